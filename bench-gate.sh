@@ -0,0 +1,156 @@
+#!/bin/sh
+#######################################################################
+# Copyright (c) 2019-2021
+#  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+#######################################################################
+
+#
+# Performance regression gate. Run through `make bench-gate`, or through
+# `make bench-baseline` to refresh the baseline.
+#
+# Runs bench.sh $BENCH_REPEAT times and summarizes each (workload,
+# scheduler, engine) by the median of ticks/sec, a ~95% confidence
+# interval of the median taken from the order statistics of the runs, and
+# the median peak RSS. Against $BENCH_BASELINE, a run regresses when
+#
+#   - the upper bound of its ticks/sec interval falls below the lower
+#     bound of the baseline by more than $BENCH_TOLERANCE, or
+#   - its median peak RSS exceeds the baseline by more than
+#     $BENCH_RSS_TOLERANCE.
+#
+# Thus noisy runs widen the intervals rather than failing the gate. Exits
+# with 1 on any regression. The knobs of bench.sh apply here as well, but
+# the baseline only covers the runs of the default settings. Ticks/sec are
+# only comparable on the same machine, so refresh the baseline where the
+# gate is run.
+#
+
+BENCH_REPEAT=${BENCH_REPEAT:-5}
+BENCH_BASELINE=${BENCH_BASELINE:-bench-baseline.tsv}
+BENCH_TOLERANCE=${BENCH_TOLERANCE:-0.05}
+BENCH_RSS_TOLERANCE=${BENCH_RSS_TOLERANCE:-0.10}
+
+update=false
+case "$1" in
+"")
+	;;
+--update)
+	update=true
+	;;
+*)
+	echo "Usage: $0 [--update]" >&2
+	exit 2
+	;;
+esac
+
+if ! $update && [ ! -f "$BENCH_BASELINE" ]; then
+	echo "No baseline $BENCH_BASELINE. Create it with $0 --update" >&2
+	exit 2
+fi
+
+workdir=$(mktemp -d "${TMPDIR:-/tmp}/sched-gate.XXXXXX") || exit 1
+trap 'rm -rf "$workdir"' EXIT INT TERM
+
+i=0
+while [ $i -lt "$BENCH_REPEAT" ]; do
+	i=$((i + 1))
+	echo "Run $i/$BENCH_REPEAT" >&2
+	BENCH_RESULTS="$workdir/run.$i" ./bench.sh > /dev/null || exit 1
+done
+
+# Summarize the runs into one line per (workload, scheduler, engine)
+awk -F '\t' '
+function median_ci(v, n, out,    i, j, t, lo, hi) {
+	for (i = 2; i <= n; i++) {
+		t = v[i]
+		for (j = i - 1; j >= 1 && v[j] > t; j--) v[j + 1] = v[j]
+		v[j + 1] = t
+	}
+	lo = int(n / 2 - 0.98 * sqrt(n))
+	hi = int(n / 2 + 1 + 0.98 * sqrt(n) + 0.999999)
+	if (lo < 1) lo = 1
+	if (hi > n) hi = n
+	out["median"] = (n % 2) ? v[(n + 1) / 2] : (v[n / 2] + v[n / 2 + 1]) / 2
+	out["lo"] = v[lo]
+	out["hi"] = v[hi]
+}
+FNR == 1 { next }
+{
+	key = $1 "\t" $2 "\t" $3
+	if (!(key in nr)) order[++nr_keys] = key
+	n = ++nr[key]
+	ticks[key] = $4
+	tps[key, n] = $8
+	rss[key, n] = $10
+}
+END {
+	printf "workload\tscheduler\tengine\tticks\truns\tticks_per_sec\tticks_per_sec_lo\tticks_per_sec_hi\tpeak_rss_kb\n"
+	for (k = 1; k <= nr_keys; k++) {
+		key = order[k]
+		n = nr[key]
+		for (i = 1; i <= n; i++) v[i] = tps[key, i]
+		median_ci(v, n, t)
+		for (i = 1; i <= n; i++) v[i] = rss[key, i]
+		median_ci(v, n, r)
+		printf "%s\t%s\t%d\t%.0f\t%.0f\t%.0f\t%.0f\n", key, ticks[key], n,
+				t["median"], t["lo"], t["hi"], r["median"]
+	}
+}' "$workdir"/run.* > "$workdir/summary"
+
+if $update; then
+	cp "$workdir/summary" "$BENCH_BASELINE"
+	echo "Updated $BENCH_BASELINE" >&2
+	exit 0
+fi
+
+awk -F '\t' -v tol="$BENCH_TOLERANCE" -v rss_tol="$BENCH_RSS_TOLERANCE" '
+FNR == 1 { next }
+NR == FNR {
+	key = $1 "\t" $2 "\t" $3
+	base_ticks[key] = $4
+	base_tps[key] = $6
+	base_lo[key] = $7
+	base_rss[key] = $9
+	next
+}
+{
+	key = $1 "\t" $2 "\t" $3
+	name = $1 " -" $2 " -E " $3
+	if (!(key in base_tps)) {
+		printf "NEW   %-24s %10.0f ticks/sec\n", name, $6
+		next
+	}
+	verdict = "OK   "
+	if ($8 < base_lo[key] * (1 - tol)) {
+		verdict = "SLOW "
+		failed = 1
+	}
+	if ($9 > base_rss[key] * (1 + rss_tol)) {
+		verdict = (verdict == "SLOW ") ? "BOTH " : "RSS  "
+		failed = 1
+	}
+	printf "%s %-24s %10.0f ticks/sec (%+6.1f%%) %8d KB (%+6.1f%%)\n",
+			verdict, name, $6, ($6 / base_tps[key] - 1) * 100,
+			$9, ($9 / base_rss[key] - 1) * 100
+	if ($4 != base_ticks[key]) {
+		printf "      %-24s simulated %d ticks, %d in the baseline\n",
+				name, $4, base_ticks[key]
+	}
+}
+END { exit failed }' "$BENCH_BASELINE" "$workdir/summary"
+status=$?
+
+if [ $status -ne 0 ]; then
+	echo "Performance regressed against $BENCH_BASELINE" >&2
+	exit 1
+fi
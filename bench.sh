@@ -0,0 +1,97 @@
+#!/bin/sh
+#######################################################################
+# Copyright (c) 2019-2021
+#  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+#######################################################################
+
+#
+# Scalability benchmark of the simulator. Run through `make bench`.
+#
+# Generates workloads of increasing size with sched-gen along three axes
+# and runs every scheduler on them quietly with `-o none -T`:
+#
+#   procs-N   : N processes without any resource
+#   res-N-K   : N processes acquiring up to K resources each
+#   wait-N-R  : N bursty processes sharing only R resources, so that
+#               more and more processes pile up on each waitqueue
+#
+# Each run appends a tab-separated line to $BENCH_RESULTS. The knobs below
+# may be overridden from the environment, e.g.,
+#   make bench BENCH_SIZES="1000 10000" BENCH_SCHEDULERS="f p"
+#
+
+BENCH_SIZES=${BENCH_SIZES:-"1000 4000 16000"}
+BENCH_SCHEDULERS=${BENCH_SCHEDULERS:-"f s S r p a i c F V L D M l t O j J n"}
+BENCH_ENGINES=${BENCH_ENGINES:-"list"}
+BENCH_SEED=${BENCH_SEED:-1}
+BENCH_RESULTS=${BENCH_RESULTS:-bench-results.tsv}
+
+SCHED=./sched
+SCHED_GEN=./sched-gen
+
+# Processes arrive at 90% of the capacity of the processor on average
+ARRIVAL="poisson:0.09"
+LIFESPAN="exp:10"
+PRIO="uniform:0,20"
+
+workdir=$(mktemp -d "${TMPDIR:-/tmp}/sched-bench.XXXXXX") || exit 1
+trap 'rm -rf "$workdir"' EXIT INT TERM
+
+# The middle size is used for the resource and waiter axes
+set -- $BENCH_SIZES
+mid=$1
+[ $# -ge 2 ] && mid=$2
+
+generate() {
+	name=$1; shift
+	$SCHED_GEN -s "$BENCH_SEED" -l "$LIFESPAN" -p "$PRIO" "$@" \
+			> "$workdir/$name" || exit 1
+	echo "$name"
+}
+
+workloads() {
+	for n in $BENCH_SIZES; do
+		generate "procs-$n" -n "$n" -a "$ARRIVAL"
+	done
+	for k in 1 2 4; do
+		generate "res-$mid-$k" -n "$mid" -a "$ARRIVAL" -r "$k" -d 2
+	done
+	for r in 16 4 1; do
+		generate "wait-$mid-$r" -n "$mid" -a "bursty:0.09,8" -r 2 -R "$r"
+	done
+}
+
+workloads > "$workdir/workloads"
+
+printf "workload\tscheduler\tengine\tticks\tevents\tload_ns\tsimulation_ns\tticks_per_sec\tevents_per_sec\tpeak_rss_kb\n" \
+		> "$BENCH_RESULTS"
+
+for w in $(cat "$workdir/workloads"); do
+	for s in $BENCH_SCHEDULERS; do
+		for e in $BENCH_ENGINES; do
+			$SCHED -q -o none -T -E "$e" -"$s" "$workdir/$w" > "$workdir/stats" || {
+				echo "$w: ./sched -$s -E $e failed" >&2
+				exit 1
+			}
+			awk -v w="$w" -v s="$s" -v e="$e" '
+				{ stat[$1] = $2 }
+				END {
+					printf "%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\n", w, s, e,
+						stat["ticks"], stat["events"],
+						stat["load_ns"], stat["simulation_ns"],
+						stat["ticks_per_sec"], stat["events_per_sec"],
+						stat["peak_rss_kb"]
+				}' "$workdir/stats" | tee -a "$BENCH_RESULTS"
+		done
+	done
+done
@@ -0,0 +1,177 @@
+#!/bin/sh
+#######################################################################
+# Copyright (c) 2019-2021
+#  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+#######################################################################
+
+#
+# Differential test between the engines. Run through `make difftest`.
+#
+# Generates random workloads with sched-gen and runs every scheduler on
+# each of them with the reference engine (the first of $DIFF_ENGINES) and
+# with every other engine. The event streams are compared tick by tick.
+# On the first divergence, prints the first differing tick and shrinks
+# the workload by dropping whole processes and then single acquisitions
+# as long as the engines still diverge. The minimal reproducer is left in
+# $DIFF_REPRO and the script exits with 1.
+#
+#   make difftest DIFF_ITERATIONS=1000 DIFF_SEED=42 DIFF_SCHEDULERS="s S"
+#
+
+DIFF_ITERATIONS=${DIFF_ITERATIONS:-100}
+DIFF_SEED=${DIFF_SEED:-1}
+DIFF_SCHEDULERS=${DIFF_SCHEDULERS:-"f s S r p a i c F V L D M l t O j J n"}
+DIFF_ENGINES=${DIFF_ENGINES:-"list soa"}
+DIFF_REPRO=${DIFF_REPRO:-difftest-repro.txt}
+
+SCHED=./sched
+SCHED_GEN=./sched-gen
+
+workdir=$(mktemp -d "${TMPDIR:-/tmp}/sched-diff.XXXXXX") || exit 1
+trap 'rm -rf "$workdir"' EXIT INT TERM
+
+set -- $DIFF_ENGINES
+reference=$1
+shift
+engines=$*
+
+# Run $sched on $1 with engine $2, leaving the events in $workdir/$2.out.
+# The exit status is appended so that crashes are caught as divergences
+run() {
+	$SCHED -q -o compact $options -E "$2" -"$sched" "$1" > "$workdir/$2.out" 2>&1
+	echo "exit $?" >> "$workdir/$2.out"
+}
+
+# Whether engine $2 diverges from the reference on the workload $1
+diverges() {
+	run "$1" "$reference"
+	run "$1" "$2"
+	! cmp -s "$workdir/$reference.out" "$workdir/$2.out"
+}
+
+report() {
+	line=$(cmp "$workdir/$reference.out" "$workdir/$1.out" 2>&1 |
+			sed -n 's/.* line \([0-9]*\).*/\1/p')
+	if [ -z "$line" ]; then
+		# One stream is a prefix of the other
+		line=$(($(wc -l < "$workdir/$reference.out") + 1))
+	fi
+	tick=$(sed -n "${line}s/^ *\([0-9]*\).*/\1/p" "$workdir/$reference.out" "$workdir/$1.out" |
+			head -n 1)
+	echo "First difference at tick ${tick:-?} (event $line):"
+	printf "  %-5s: %s\n" "$reference" "$(sed -n "${line}p" "$workdir/$reference.out")"
+	printf "  %-5s: %s\n" "$1" "$(sed -n "${line}p" "$workdir/$1.out")"
+}
+
+# Drop the $2-th process block from $1
+drop_process() {
+	awk -v skip="$2" '
+		/^process/ { n++ }
+		n == skip { if (/^end/) n++; next }
+		{ print }' "$1"
+}
+
+# Drop the $2-th acquire line from $1
+drop_acquire() {
+	awk -v skip="$2" '/^[ \t]*acquire/ { if (++n == skip) next } { print }' "$1"
+}
+
+# Shrink the workload $1 diverging on engine $2 into $DIFF_REPRO
+shrink() {
+	cp "$1" "$DIFF_REPRO"
+
+	for unit in process acquire; do
+		changed=true
+		while $changed; do
+			changed=false
+			if [ $unit = process ]; then
+				nr=$(grep -c '^process' "$DIFF_REPRO")
+			else
+				nr=$(grep -c '^[[:space:]]*acquire' "$DIFF_REPRO")
+			fi
+			i=$nr
+			while [ "$i" -ge 1 ]; do
+				drop_$unit "$DIFF_REPRO" "$i" > "$workdir/candidate"
+				if diverges "$workdir/candidate" "$2"; then
+					cp "$workdir/candidate" "$DIFF_REPRO"
+					changed=true
+				fi
+				i=$((i - 1))
+			done
+		done
+	done
+}
+
+if [ -z "$engines" ]; then
+	echo "Need at least two engines to compare" >&2
+	exit 2
+fi
+
+iteration=0
+while [ $iteration -lt "$DIFF_ITERATIONS" ]; do
+	seed=$((DIFF_SEED + iteration))
+	iteration=$((iteration + 1))
+
+	# Vary the shape of workloads along with the seed. Odd seeds split
+	# lifespans into CPU phases with I/O in between
+	io=
+	if [ $((seed % 2)) -eq 1 ]; then
+		io="-I bursts:$((seed / 2 % 3 + 1)),$((seed % 5 + 1))"
+	fi
+	# Seeds of 2 mod 4 make some processes periodic, and every other one
+	# of them cuts the releases off at an early horizon
+	periodic=
+	options=
+	if [ $((seed % 4)) -eq 2 ]; then
+		periodic="-T harmonic:0.$((seed % 5 + 3)),$((seed % 5 + 4)),3"
+		if [ $((seed % 8)) -eq 6 ]; then
+			options="-P $((seed % 50 + 10))"
+		fi
+	fi
+	$SCHED_GEN -s $seed -n $((seed % 40 + 2)) \
+			-a "bursty:0.$((seed % 5 + 1)),$((seed % 4 + 1))" \
+			-l "exp:$((seed % 8 + 2))" \
+			-p "uniform:0,$((seed % 3 * 10))" \
+			-r $((seed % 4)) -d $((seed % 3 + 1)) -R $((seed % 4 + 1)) \
+			-D "slack:0.$((seed % 9 + 1)),1,$((seed % 4 + 2))" \
+			$io $periodic > "$workdir/workload" || exit 1
+
+	# Every third seed admits processes with deadlines under EDF
+	if [ $((seed % 3)) -eq 0 ]; then
+		options="$options -k edf.admission=1"
+	fi
+
+	# Every fifth seed reports the share error, with or without the cost
+	# of context switches
+	if [ $((seed % 5)) -eq 4 ]; then
+		options="$options -w $((seed % 7 + 2)) -x $((seed % 3))"
+	fi
+
+	for sched in $DIFF_SCHEDULERS; do
+		for engine in $engines; do
+			diverges "$workdir/workload" "$engine" || continue
+
+			echo "Seed $seed: -$sched -E $engine diverges from -E $reference"
+			report "$engine"
+			echo "Shrinking..."
+			shrink "$workdir/workload" "$engine"
+			diverges "$DIFF_REPRO" "$engine"
+			report "$engine"
+			echo "Minimal reproducer in $DIFF_REPRO:"
+			echo "  $SCHED -o compact $options -E $engine -$sched $DIFF_REPRO"
+			exit 1
+		done
+	done
+done
+
+echo "No divergence in $DIFF_ITERATIONS workloads"
@@ -0,0 +1,81 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "heap.h"
+
+static inline bool __less(const struct heap_node *a, const struct heap_node *b)
+{
+	return a->key < b->key || (a->key == b->key && a->seq < b->seq);
+}
+
+void heap_push(struct heap *h, unsigned long long key, void *data)
+{
+	struct heap_node node = { key, h->seq++, data };
+	size_t i;
+
+	if (h->nr == h->max) {
+		h->max = h->max ? h->max * 2 : 64;
+		h->nodes = realloc(h->nodes, h->max * sizeof(*h->nodes));
+		assert(h->nodes);
+	}
+
+	/* Sift up from the new leaf */
+	for (i = h->nr++; i > 0; ) {
+		size_t parent = (i - 1) / 2;
+
+		if (!__less(&node, h->nodes + parent)) break;
+		h->nodes[i] = h->nodes[parent];
+		i = parent;
+	}
+	h->nodes[i] = node;
+}
+
+void *heap_pop(struct heap *h)
+{
+	struct heap_node last;
+	void *data;
+	size_t i = 0;
+
+	if (!h->nr) return NULL;
+
+	data = h->nodes[0].data;
+	last = h->nodes[--h->nr];
+
+	/* Sift the last one down from the root */
+	while (true) {
+		size_t child = i * 2 + 1;
+
+		if (child >= h->nr) break;
+		if (child + 1 < h->nr && __less(h->nodes + child + 1, h->nodes + child)) {
+			child++;
+		}
+		if (!__less(h->nodes + child, &last)) break;
+		h->nodes[i] = h->nodes[child];
+		i = child;
+	}
+	if (h->nr) h->nodes[i] = last;
+
+	return data;
+}
+
+void heap_destroy(struct heap *h)
+{
+	free(h->nodes);
+	h->nodes = NULL;
+	h->nr = h->max = 0;
+}
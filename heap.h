@@ -0,0 +1,66 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#ifndef __HEAP_H__
+#define __HEAP_H__
+
+#include <stddef.h>
+
+#include "types.h"
+
+/***********************************************************************
+ * struct heap
+ *
+ * DESCRIPTION
+ *   Binary min-heap of pointers keyed by 64-bit integers. Entries with
+ *   the same key come out in the order they were pushed, so schedulers
+ *   built on it break ties first-come first-served. Push and pop are
+ *   O(log N), and the array grows by doubling.
+ */
+struct heap_node {
+	unsigned long long key;
+	unsigned long long seq;		/* Push order to break ties */
+	void *data;
+};
+
+struct heap {
+	struct heap_node *nodes;
+	size_t nr;
+	size_t max;
+	unsigned long long seq;
+};
+
+#define HEAP_INIT { NULL, 0, 0, 0 }
+
+static inline bool heap_empty(const struct heap *h)
+{
+	return h->nr == 0;
+}
+
+static inline void *heap_peek(const struct heap *h)
+{
+	return h->nr ? h->nodes[0].data : NULL;
+}
+
+static inline unsigned long long heap_peek_key(const struct heap *h)
+{
+	return h->nodes[0].key;
+}
+
+void heap_push(struct heap *h, unsigned long long key, void *data);
+void *heap_pop(struct heap *h);
+void heap_destroy(struct heap *h);
+
+#endif
@@ -0,0 +1,76 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#include <stdio.h>
+
+#include "hist.h"
+
+void hist_bucket_range(unsigned int bucket, unsigned int *lo, unsigned int *hi)
+{
+	unsigned int shift, sub;
+
+	if (bucket < 2 * HIST_SUB_BUCKETS) {
+		*lo = *hi = bucket;
+		return;
+	}
+
+	shift = bucket / HIST_SUB_BUCKETS - 1;
+	sub = bucket % HIST_SUB_BUCKETS + HIST_SUB_BUCKETS;
+
+	*lo = sub << shift;
+	*hi = *lo + ((1U << shift) - 1);
+}
+
+void hist_merge(struct hist *dst, const struct hist *src)
+{
+	for (unsigned int i = 0; i < HIST_NR_BUCKETS; i++) {
+		dst->buckets[i] += src->buckets[i];
+	}
+	dst->count += src->count;
+	if (src->max > dst->max) dst->max = src->max;
+}
+
+unsigned int hist_percentile(const struct hist *h, double pct)
+{
+	unsigned long long rank, seen = 0;
+	unsigned int lo, hi;
+
+	if (!h->count) return 0;
+
+	rank = (unsigned long long)(pct / 100.0 * h->count + 0.5);
+	if (rank < 1) rank = 1;
+	if (rank > h->count) rank = h->count;
+
+	for (unsigned int i = 0; i < HIST_NR_BUCKETS; i++) {
+		seen += h->buckets[i];
+		if (seen >= rank) {
+			hist_bucket_range(i, &lo, &hi);
+			return hi < h->max ? hi : h->max;
+		}
+	}
+	return h->max;
+}
+
+void hist_dump(const struct hist *h, const char *prefix, FILE *file)
+{
+	unsigned int lo, hi;
+
+	for (unsigned int i = 0; i < HIST_NR_BUCKETS; i++) {
+		if (!h->buckets[i]) continue;
+
+		hist_bucket_range(i, &lo, &hi);
+		fprintf(file, "%s %u %u %llu\n", prefix, lo, hi, h->buckets[i]);
+	}
+}
@@ -0,0 +1,75 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#ifndef __HIST_H__
+#define __HIST_H__
+
+#include <stdio.h>
+
+/***********************************************************************
+ * struct hist
+ *
+ * DESCRIPTION
+ *   HDR-style log-bucketed histogram of unsigned int values. Values below
+ *   2 * HIST_SUB_BUCKETS are counted exactly. Above that, each power-of-two
+ *   range is split into HIST_SUB_BUCKETS buckets, so a value is reported
+ *   within 1 / HIST_SUB_BUCKETS (~3%) of its magnitude.
+ *
+ *   Recording is O(1). Histograms are merged by adding up the counts of
+ *   the same bucket, so those from different runs or threads can be
+ *   combined with hist_merge() or by summing the dumped buckets.
+ */
+#define HIST_SUB_BITS		5
+#define HIST_SUB_BUCKETS	(1U << HIST_SUB_BITS)
+#define HIST_NR_BUCKETS		((32 - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS)
+
+struct hist {
+	unsigned long long count;
+	unsigned int max;
+	unsigned long long buckets[HIST_NR_BUCKETS];
+};
+
+static inline unsigned int hist_bucket(unsigned int value)
+{
+	unsigned int shift;
+
+	if (value < 2 * HIST_SUB_BUCKETS) return value;
+
+	shift = 31 - __builtin_clz(value) - HIST_SUB_BITS;
+	return (shift + 1) * HIST_SUB_BUCKETS + (value >> shift) - HIST_SUB_BUCKETS;
+}
+
+static inline void hist_record(struct hist *h, unsigned int value)
+{
+	h->buckets[hist_bucket(value)]++;
+	h->count++;
+	if (value > h->max) h->max = value;
+}
+
+void hist_bucket_range(unsigned int bucket, unsigned int *lo, unsigned int *hi);
+void hist_merge(struct hist *dst, const struct hist *src);
+
+/**
+ * Value at percentile @pct (0 - 100). It is the highest value of the bucket
+ * the percentile falls into, capped by the largest recorded value.
+ */
+unsigned int hist_percentile(const struct hist *h, double pct);
+
+/**
+ * Print non-empty buckets as "@prefix lo hi count" lines to @file
+ */
+void hist_dump(const struct hist *h, const char *prefix, FILE *file);
+
+#endif
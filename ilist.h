@@ -0,0 +1,165 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#ifndef __ILIST_H__
+#define __ILIST_H__
+
+#include "pool.h"
+
+/*
+ * Index-based doubly linked list.
+ *
+ * This is a counterpart of list_head.h for objects that live in a struct
+ * pool. Entries are linked by their 32-bit pool indices instead of
+ * pointers, so a node takes 8 bytes instead of 16. Since a node cannot
+ * point back to the head, lists are not circular; the head keeps the first
+ * and the last index, and the functions that unlink an entry take the head.
+ *
+ * Every function takes the pool holding the entries and the offset of the
+ * struct ilist_node in the entry (i.e., offsetof(type, member)).
+ */
+
+#define ILIST_NIL	POOL_NO_INDEX
+
+struct ilist_node {
+	unsigned int next, prev;
+};
+
+struct ilist_head {
+	unsigned int first, last;
+};
+
+#define ILIST_HEAD_INIT(name) { ILIST_NIL, ILIST_NIL }
+
+#define ILIST_HEAD(name) \
+	struct ilist_head name = ILIST_HEAD_INIT(name)
+
+static inline void INIT_ILIST_HEAD(struct ilist_head *head)
+{
+	head->first = head->last = ILIST_NIL;
+}
+
+static inline int ilist_empty(const struct ilist_head *head)
+{
+	return head->first == ILIST_NIL;
+}
+
+static inline struct ilist_node *__ilist_node(struct pool *pool,
+		size_t offset, unsigned int index)
+{
+	return (struct ilist_node *)((char *)pool_at(pool, index) + offset);
+}
+
+/**
+ * ilist_entry - get the struct for this index
+ * @pool:	the pool holding the entry.
+ * @index:	the index of the entry.
+ * @type:	the type of the struct.
+ */
+#define ilist_entry(pool, index, type) \
+	((type *)pool_at(pool, index))
+
+/**
+ * ilist_add_tail - add a new entry
+ * @pool:	the pool holding the entries.
+ * @offset:	the offset of struct ilist_node in the entry.
+ * @index:	index of the new entry.
+ * @head:	list head to add it before.
+ */
+static inline void ilist_add_tail(struct pool *pool, size_t offset,
+		unsigned int index, struct ilist_head *head)
+{
+	struct ilist_node *node = __ilist_node(pool, offset, index);
+
+	node->next = ILIST_NIL;
+	node->prev = head->last;
+
+	if (head->last == ILIST_NIL) {
+		head->first = index;
+	} else {
+		__ilist_node(pool, offset, head->last)->next = index;
+	}
+	head->last = index;
+}
+
+/**
+ * ilist_del - deletes entry from list.
+ * @pool:	the pool holding the entries.
+ * @offset:	the offset of struct ilist_node in the entry.
+ * @index:	index of the entry to delete.
+ * @head:	list head the entry is in.
+ */
+static inline void ilist_del(struct pool *pool, size_t offset,
+		unsigned int index, struct ilist_head *head)
+{
+	struct ilist_node *node = __ilist_node(pool, offset, index);
+
+	if (node->prev == ILIST_NIL) {
+		head->first = node->next;
+	} else {
+		__ilist_node(pool, offset, node->prev)->next = node->next;
+	}
+
+	if (node->next == ILIST_NIL) {
+		head->last = node->prev;
+	} else {
+		__ilist_node(pool, offset, node->next)->prev = node->prev;
+	}
+
+	node->next = node->prev = ILIST_NIL;
+}
+
+/**
+ * ilist_move_tail - delete from one list and add as another's tail
+ * @pool:	the pool holding the entries.
+ * @offset:	the offset of struct ilist_node in the entry.
+ * @index:	index of the entry to move.
+ * @from:	the head of the list the entry is in.
+ * @head:	the head that will follow our entry.
+ */
+static inline void ilist_move_tail(struct pool *pool, size_t offset,
+		unsigned int index, struct ilist_head *from, struct ilist_head *head)
+{
+	ilist_del(pool, offset, index, from);
+	ilist_add_tail(pool, offset, index, head);
+}
+
+/**
+ * ilist_for_each - iterate over a list
+ * @pool:	the pool holding the entries.
+ * @offset:	the offset of struct ilist_node in the entry.
+ * @index:	the unsigned int to use as a loop cursor.
+ * @head:	the head for your list.
+ */
+#define ilist_for_each(pool, offset, index, head) \
+	for (index = (head)->first; index != ILIST_NIL; \
+	     index = __ilist_node(pool, offset, index)->next)
+
+/**
+ * ilist_for_each_safe - iterate over a list safe against removal of list entry
+ * @pool:	the pool holding the entries.
+ * @offset:	the offset of struct ilist_node in the entry.
+ * @index:	the unsigned int to use as a loop cursor.
+ * @n:		another unsigned int to use as temporary storage
+ * @head:	the head for your list.
+ */
+#define ilist_for_each_safe(pool, offset, index, n, head) \
+	for (index = (head)->first, \
+	     n = index == ILIST_NIL ? ILIST_NIL : __ilist_node(pool, offset, index)->next; \
+	     index != ILIST_NIL; \
+	     index = n, \
+	     n = index == ILIST_NIL ? ILIST_NIL : __ilist_node(pool, offset, index)->next)
+
+#endif
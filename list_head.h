@@ -9,7 +9,9 @@
  * @member: the name of the member within the struct.
  *
  */
+#ifndef offsetof
 #define offsetof(TYPE, MEMBER)  ((size_t)&((TYPE *)0)->MEMBER)
+#endif
 
 #define container_of(ptr, type, member) ({              \
     void *__mptr = (void *)(ptr);                   \
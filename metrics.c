@@ -0,0 +1,678 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "types.h"
+#include "list_head.h"
+#include "process.h"
+#include "resource.h"
+#include "metrics.h"
+#include "hist.h"
+
+extern unsigned int ticks;
+extern struct resource resources[NR_RESOURCES];
+
+bool metrics = false;
+
+/**
+ * Metrics of the exited processes. Only kept when @metrics is set
+ */
+static struct proc_metrics *__rows = NULL;
+static size_t __nr_rows = 0;
+static size_t __max_rows = 0;
+
+/**
+ * Aggregates over all exited processes
+ */
+enum {
+	AGG_TURNAROUND,
+	AGG_RESPONSE,
+	AGG_READY,
+	AGG_BLOCKED,
+	AGG_RESOURCE_WAIT,
+	AGG_IO,
+	AGG_SWITCHES,
+	AGG_SWITCH_OVERHEAD,
+	NR_AGGS,
+};
+
+static const char * __agg_sz[] = {
+	"turnaround",
+	"response",
+	"ready",
+	"blocked",
+	"resource_wait",
+	"io",
+	"switches",
+	"switch_overhead",
+};
+
+static struct {
+	unsigned long long sum;
+	unsigned int max;
+} __aggs[NR_AGGS];
+
+static size_t __nr_exited = 0;
+
+/**
+ * Fairness over the exited processes. The share of a process is the
+ * fraction of its lifetime out of I/O it spent running,
+ * run / (turnaround - io), and the slowdown is its reciprocal. Jain's
+ * index over the shares is 1 when every process gets the same share and
+ * approaches 1/n as one dominates.
+ */
+static double __share_sum = 0, __share_sq = 0;
+static double __slowdown_sum = 0, __slowdown_max = 0;
+static size_t __nr_shares = 0;
+
+/**
+ * Deadlines met and missed by the processes having ones. The tardiness is
+ * the ticks a process completed past its deadline, 0 if it met the one.
+ */
+static unsigned long long __nr_deadlines = 0;
+static unsigned long long __nr_misses = 0;
+static unsigned long long __tardiness_sum = 0;
+static struct hist __tardiness;
+
+/**
+ * Context switches over the whole simulation and the ticks charged for them
+ */
+static unsigned long long __nr_switches = 0;
+static unsigned long long __switch_overhead = 0;
+
+/**
+ * Utilization of the processor and the I/O device. The device serves any
+ * number of I/Os at once, and is busy while at least one is outstanding
+ */
+static unsigned long long __run_ticks = 0;
+static unsigned long long __nr_ios = 0;
+static unsigned int __ios = 0, __max_ios = 0;
+static unsigned int __ios_since = 0;
+static unsigned long long __io_busy = 0, __ios_area = 0;
+
+static void __ios_change(int delta, unsigned int t)
+{
+	if (__ios) {
+		__io_busy += t - __ios_since;
+		__ios_area += (unsigned long long)__ios * (t - __ios_since);
+	}
+	__ios_since = t;
+	__ios += delta;
+	if (__ios > __max_ios) __max_ios = __ios;
+}
+
+bool histograms = false;
+
+/**
+ * Latency histograms broken down by the original priority of processes.
+ * Priorities are grouped into NR_PRIO_CLASSES classes of equal width, and
+ * those of MAX_PRIO and above go into the last class.
+ */
+#define NR_PRIO_CLASSES	4
+#define PRIO_CLASS_WIDTH	(MAX_PRIO / NR_PRIO_CLASSES)
+
+enum {
+	HIST_WAITING,
+	HIST_RESPONSE,
+	HIST_BLOCKING,
+	NR_HISTS,
+};
+
+static const char * __hist_sz[] = {
+	"waiting",
+	"response",
+	"blocking",
+};
+
+static struct hist __hists[NR_HISTS][NR_PRIO_CLASSES];
+
+static inline int __prio_class(unsigned int prio)
+{
+	int class = prio / PRIO_CLASS_WIDTH;
+	return class < NR_PRIO_CLASSES ? class : NR_PRIO_CLASSES - 1;
+}
+
+static void __prio_class_sz(int class, char *buf, size_t len)
+{
+	if (class == NR_PRIO_CLASSES - 1) {
+		snprintf(buf, len, "%d+", class * PRIO_CLASS_WIDTH);
+	} else {
+		snprintf(buf, len, "%d-%d", class * PRIO_CLASS_WIDTH,
+				(class + 1) * PRIO_CLASS_WIDTH - 1);
+	}
+}
+
+
+bool resource_metrics = false;
+
+/**
+ * Contention on each resource
+ */
+static struct resource_metrics {
+	unsigned long long acquires;
+	unsigned long long contended;	/* Acquisitions that blocked at least once */
+	unsigned long long hold;		/* Ticks held */
+	unsigned int held_since;
+
+	unsigned long long blocked;		/* Ticks the waiters were blocked for */
+
+	unsigned int waiters;			/* Current waitqueue length */
+	unsigned int max_waiters;
+	unsigned long long waiters_area;	/* Integral of @waiters over ticks */
+	unsigned int waiters_since;
+
+	unsigned long long inversion;	/* Ticks of priority inversion on this */
+} __resources[NR_RESOURCES];
+
+/**
+ * Ticks during which a process was blocked while a lower-priority process
+ * that it does not depend on was running
+ */
+static unsigned long long __inversion = 0;
+
+static void __waiters_change(int resource_id, int delta)
+{
+	struct resource_metrics *r = __resources + resource_id;
+
+	r->waiters_area += (unsigned long long)r->waiters * (ticks - r->waiters_since);
+	r->waiters_since = ticks;
+	r->waiters += delta;
+	if (r->waiters > r->max_waiters) r->max_waiters = r->waiters;
+}
+
+unsigned int share_window = 0;
+
+/**
+ * CPU shares against the tickets of processes. The ideal is the fluid
+ * share of GPS, where each runnable process receives tickets / (tickets of
+ * all runnable processes) of every tick. This is tracked with the virtual
+ * time @__share_vtime advancing by 1 / @__share_tickets per tick, so the
+ * ideal service of a process is its tickets times the advance of the
+ * virtual time while it is runnable.
+ *
+ * For each window of @share_window ticks, the error is the sum of
+ * |actual - ideal| service over the processes halved and divided by the
+ * window, i.e., the fraction of the window given to the wrong processes.
+ * Processes are runnable from fork to exit except while in waitqueues.
+ */
+struct share_sample {
+	struct process *p;
+	unsigned int ran;		/* Ticks run in the current window */
+	double vstart;			/* Virtual time the window started at */
+};
+
+static struct share_sample *__share_procs = NULL;
+static unsigned int __nr_share_procs = 0;
+static unsigned int __max_share_procs = 0;
+
+static double __share_vtime = 0;
+static unsigned long long __share_tickets = 0;
+static unsigned int __share_since = 0;
+
+static double __window_error = 0;
+static double __window_error_sum = 0, __window_error_max = 0;
+static unsigned int __nr_windows = 0;
+static struct hist __window_errors;		/* In permille */
+
+/* Advance the virtual time up to tick @t */
+static void __share_advance(unsigned int t)
+{
+	if (t <= __share_since) return;
+
+	if (__share_tickets) {
+		__share_vtime += (double)(t - __share_since) / __share_tickets;
+	}
+	__share_since = t;
+}
+
+/* Fold the service of @s since the last window into the error */
+static void __share_settle(struct share_sample *s)
+{
+	double ideal = s->p->tickets * (__share_vtime - s->vstart);
+	double error = s->ran - ideal;
+
+	__window_error += error >= 0 ? error : -error;
+	s->vstart = __share_vtime;
+	s->ran = 0;
+}
+
+static void __share_join(struct process *p, unsigned int t)
+{
+	if (!share_window || p->__share_slot != METRICS_NONE) return;
+
+	__share_advance(t);
+
+	if (__nr_share_procs == __max_share_procs) {
+		__max_share_procs = __max_share_procs ? __max_share_procs * 2 : 64;
+		__share_procs = realloc(__share_procs,
+				sizeof(*__share_procs) * __max_share_procs);
+		assert(__share_procs);
+	}
+	p->__share_slot = __nr_share_procs;
+	__share_procs[__nr_share_procs++] = (struct share_sample) {
+		.p = p,
+		.ran = 0,
+		.vstart = __share_vtime,
+	};
+	__share_tickets += p->tickets;
+}
+
+static void __share_leave(struct process *p, unsigned int t)
+{
+	struct share_sample *s;
+
+	if (!share_window || p->__share_slot == METRICS_NONE) return;
+
+	__share_advance(t);
+	s = __share_procs + p->__share_slot;
+	__share_settle(s);
+
+	*s = __share_procs[--__nr_share_procs];
+	s->p->__share_slot = p->__share_slot;
+	p->__share_slot = METRICS_NONE;
+	__share_tickets -= p->tickets;
+}
+
+/**
+ * Close the window ending at the current tick
+ */
+void metrics_share_window(void)
+{
+	double error;
+
+	__share_advance(ticks);
+	for (unsigned int i = 0; i < __nr_share_procs; i++) {
+		__share_settle(__share_procs + i);
+	}
+
+	error = __window_error / 2 / share_window;
+	__window_error = 0;
+
+	__window_error_sum += error;
+	if (error > __window_error_max) __window_error_max = error;
+	hist_record(&__window_errors, (unsigned int)(error * 1000 + 0.5));
+	__nr_windows++;
+}
+
+void metrics_fork(struct process *p)
+{
+	p->__first_run = METRICS_NONE;
+	p->__wait_since = METRICS_NONE;
+	p->__wait_resource = -1;
+	p->__blocked_ticks = 0;
+	p->__wait_ticks = 0;
+	p->__io_ticks = 0;
+	p->__switches = 0;
+	p->__switch_ticks = 0;
+
+	p->__share_slot = METRICS_NONE;
+	__share_join(p, ticks);
+}
+
+void metrics_dispatch(struct process *p, struct process *prev)
+{
+	if (p == prev) return;
+
+	if (p->__first_run == METRICS_NONE) p->__first_run = ticks;
+	p->__switches++;
+	__nr_switches++;
+}
+
+/**
+ * Whether the process blocked on @p depends on @q, i.e., @q holds the
+ * resource @p is waiting for, or @q holds the one the owner of it is
+ * waiting for, and so on
+ */
+static bool __depends_on(struct process *p, struct process *q)
+{
+	for (int i = 0; i < NR_RESOURCES; i++) {
+		struct process *owner = resources[p->__wait_resource].owner;
+
+		if (!owner) return false;
+		if (owner == q) return true;
+		if (owner->status != PROCESS_WAIT || owner->__wait_resource < 0) {
+			return false;
+		}
+		p = owner;
+	}
+	return false;
+}
+
+/**
+ * @p makes a progress in this tick. Check whether a higher-priority process
+ * is blocked meanwhile for a reason unrelated to @p.
+ */
+void metrics_run(struct process *p)
+{
+	bool inverted = false;
+
+	if (p->__share_slot != METRICS_NONE) __share_procs[p->__share_slot].ran++;
+	__run_ticks++;
+
+	if (!resource_metrics) return;
+
+	for (int i = 0; i < NR_RESOURCES; i++) {
+		struct process *w;
+
+		if (!__resources[i].waiters) continue;
+
+		list_for_each_entry(w, &resources[i].waitqueue, list) {
+			if (w->prio_orig > p->prio_orig && !__depends_on(w, p)) {
+				__resources[i].inversion++;
+				inverted = true;
+				break;
+			}
+		}
+	}
+	if (inverted) __inversion++;
+}
+
+/**
+ * @p could not acquire @resource_id in this tick, and is put into the
+ * waitqueue of the resource from the next tick on
+ */
+void metrics_block(struct process *p, int resource_id)
+{
+	p->__blocked_ticks++;
+	p->__wait_since = ticks + 1;
+
+	if (p->__wait_resource != resource_id) {
+		__resources[resource_id].contended++;
+		p->__wait_resource = resource_id;
+	}
+	__resources[resource_id].blocked++;
+	__waiters_change(resource_id, 1);
+
+	__share_leave(p, ticks + 1);
+}
+
+void metrics_acquire(struct process *p, int resource_id)
+{
+	__resources[resource_id].acquires++;
+	__resources[resource_id].held_since = ticks;
+
+	if (p->__wait_resource == resource_id) p->__wait_resource = -1;
+}
+
+void metrics_release(int resource_id)
+{
+	__resources[resource_id].hold += ticks - __resources[resource_id].held_since + 1;
+}
+
+/**
+ * The processor spends this tick switching into @p
+ */
+void metrics_switch_overhead(struct process *p)
+{
+	p->__switch_ticks++;
+	__switch_overhead++;
+}
+
+/**
+ * @p is woken up from a resource waitqueue while the current process is
+ * releasing the resource. It is ready from the next tick on.
+ */
+void metrics_wakeup(struct process *p)
+{
+	unsigned int waited = ticks + 1 - p->__wait_since;
+
+	p->__wait_ticks += waited;
+	p->__wait_since = METRICS_NONE;
+
+	__resources[p->__wait_resource].blocked += waited;
+	__waiters_change(p->__wait_resource, -1);
+
+	__share_join(p, ticks + 1);
+}
+
+/**
+ * @p has finished a CPU phase in this tick, and sleeps for I/O from the
+ * next tick on
+ */
+void metrics_sleep(struct process *p)
+{
+	p->__io_since = ticks + 1;
+	__nr_ios++;
+	__ios_change(1, ticks + 1);
+
+	__share_leave(p, ticks + 1);
+}
+
+/**
+ * @p has completed I/O, and is ready from this tick on
+ */
+void metrics_io_wakeup(struct process *p)
+{
+	p->__io_ticks += ticks - p->__io_since;
+	__ios_change(-1, ticks);
+
+	__share_join(p, ticks);
+}
+
+static inline void __aggregate(int agg, unsigned int value)
+{
+	__aggs[agg].sum += value;
+	if (value > __aggs[agg].max) __aggs[agg].max = value;
+}
+
+void metrics_exit(struct process *p)
+{
+	struct proc_metrics m = {
+		.pid = p->pid,
+		.prio = p->prio_orig,
+		.arrival = p->__starts_at,
+		.first_run = p->__first_run,
+		.completion = ticks,
+		.deadline = p->deadline,
+		.run = p->age,
+		.blocked = p->__blocked_ticks,
+		.resource_wait = p->__wait_ticks,
+		.io = p->__io_ticks,
+		.switches = p->__switches,
+		.switch_overhead = p->__switch_ticks,
+	};
+	__share_leave(p, ticks);
+
+	m.ready = metrics_turnaround(&m) - m.run - m.blocked - m.resource_wait -
+			m.io - m.switch_overhead;
+
+	__aggregate(AGG_TURNAROUND, metrics_turnaround(&m));
+	__aggregate(AGG_RESPONSE, metrics_response(&m));
+	__aggregate(AGG_READY, m.ready);
+	__aggregate(AGG_BLOCKED, m.blocked);
+	__aggregate(AGG_RESOURCE_WAIT, m.resource_wait);
+	__aggregate(AGG_IO, m.io);
+	__aggregate(AGG_SWITCHES, m.switches);
+	__aggregate(AGG_SWITCH_OVERHEAD, m.switch_overhead);
+	__nr_exited++;
+
+	if (m.deadline) {
+		unsigned int tardiness =
+				m.completion > m.deadline ? m.completion - m.deadline : 0;
+
+		__nr_deadlines++;
+		if (tardiness) __nr_misses++;
+		__tardiness_sum += tardiness;
+		hist_record(&__tardiness, tardiness);
+	}
+
+	if (m.run && metrics_turnaround(&m) > m.io) {
+		double share = (double)m.run / (metrics_turnaround(&m) - m.io);
+
+		__share_sum += share;
+		__share_sq += share * share;
+		__slowdown_sum += 1 / share;
+		if (1 / share > __slowdown_max) __slowdown_max = 1 / share;
+		__nr_shares++;
+	}
+
+	if (histograms) {
+		int class = __prio_class(m.prio);
+		hist_record(&__hists[HIST_WAITING][class], m.ready);
+		hist_record(&__hists[HIST_RESPONSE][class], metrics_response(&m));
+		hist_record(&__hists[HIST_BLOCKING][class], m.blocked + m.resource_wait);
+	}
+
+	if (!metrics) return;
+
+	if (__nr_rows == __max_rows) {
+		__max_rows = __max_rows ? __max_rows * 2 : 1024;
+		__rows = realloc(__rows, __max_rows * sizeof(*__rows));
+		assert(__rows);
+	}
+	__rows[__nr_rows++] = m;
+}
+
+void metrics_report(const char *name)
+{
+	printf("***** METRICS: %s *****\n", name);
+	printf("%6s %7s %7s %7s %10s %8s %7s %7s %7s %7s %8s %8s\n",
+			"pid", "arrival", "first", "finish", "turnaround", "response",
+			"ready", "blocked", "rwait", "io", "switches", "overhead");
+	for (size_t i = 0; i < __nr_rows; i++) {
+		struct proc_metrics *m = __rows + i;
+		printf("%6u %7u %7u %7u %10u %8u %7u %7u %7u %7u %8u %8u\n",
+				m->pid, m->arrival, m->first_run, m->completion,
+				metrics_turnaround(m), metrics_response(m),
+				m->ready, m->blocked, m->resource_wait, m->io, m->switches,
+				m->switch_overhead);
+	}
+
+	printf("\n%-15s %12s %10s\n", "", "mean", "max");
+	for (int i = 0; i < NR_AGGS; i++) {
+		printf("%-15s %12.2f %10u\n", __agg_sz[i],
+				__nr_exited ? (double)__aggs[i].sum / __nr_exited : 0.0,
+				__aggs[i].max);
+	}
+	printf("%-15s %12.2f %10.2f\n", "slowdown",
+			__nr_shares ? __slowdown_sum / __nr_shares : 0.0, __slowdown_max);
+	printf("%-15s %12zu\n", "processes", __nr_exited);
+	printf("\nfairness (Jain's index of run/turnaround) %.4f\n",
+			__share_sq ? __share_sum * __share_sum / (__nr_shares * __share_sq) : 1.0);
+	if (__nr_deadlines) {
+		printf("\ndeadlines %llu, missed %llu (%.2f%%)\n", __nr_deadlines,
+				__nr_misses, 100.0 * __nr_misses / __nr_deadlines);
+		printf("tardiness mean %.2f, p50 %u, p90 %u, p99 %u, max %u\n",
+				(double)__tardiness_sum / __nr_deadlines,
+				hist_percentile(&__tardiness, 50), hist_percentile(&__tardiness, 90),
+				hist_percentile(&__tardiness, 99), __tardiness.max);
+	}
+	printf("\ncontext switches %llu, overhead %llu ticks (%.2f%% of %u ticks)\n",
+			__nr_switches, __switch_overhead,
+			ticks ? 100.0 * __switch_overhead / ticks : 0.0, ticks);
+
+	__ios_change(0, ticks);
+	printf("cpu utilization %.2f%%\n", ticks ? 100.0 * __run_ticks / ticks : 0.0);
+	if (__nr_ios) {
+		printf("device utilization %.2f%% (%llu I/Os, outstanding mean %.2f, max %u)\n",
+				ticks ? 100.0 * __io_busy / ticks : 0.0, __nr_ios,
+				ticks ? (double)__ios_area / ticks : 0.0, __max_ios);
+	}
+	printf("\n");
+}
+
+static void __print_percentiles(const char *metric, const char *class,
+		const struct hist *h)
+{
+	printf("%-9s %-6s %10llu %8u %8u %8u %8u %8u\n", metric, class, h->count,
+			hist_percentile(h, 50), hist_percentile(h, 90),
+			hist_percentile(h, 99), hist_percentile(h, 99.9), h->max);
+}
+
+void metrics_report_histograms(const char *name)
+{
+	char class_sz[16];
+
+	printf("***** LATENCY HISTOGRAMS: %s *****\n", name);
+	printf("%-9s %-6s %10s %8s %8s %8s %8s %8s\n", "metric", "prio",
+			"count", "p50", "p90", "p99", "p99.9", "max");
+
+	for (int i = 0; i < NR_HISTS; i++) {
+		static struct hist all;
+
+		memset(&all, 0x00, sizeof(all));
+		for (int c = 0; c < NR_PRIO_CLASSES; c++) {
+			hist_merge(&all, &__hists[i][c]);
+		}
+		__print_percentiles(__hist_sz[i], "all", &all);
+
+		for (int c = 0; c < NR_PRIO_CLASSES; c++) {
+			if (!__hists[i][c].count) continue;
+			__prio_class_sz(c, class_sz, sizeof(class_sz));
+			__print_percentiles(__hist_sz[i], class_sz, &__hists[i][c]);
+		}
+	}
+	printf("\n");
+}
+
+/**
+ * Dump the raw buckets as "metric prio lo hi count" lines. Dumps from
+ * different runs are merged by adding up the counts of the same rows.
+ */
+void metrics_dump_histograms(FILE *file)
+{
+	char prefix[32], class_sz[16];
+
+	for (int i = 0; i < NR_HISTS; i++) {
+		for (int c = 0; c < NR_PRIO_CLASSES; c++) {
+			__prio_class_sz(c, class_sz, sizeof(class_sz));
+			snprintf(prefix, sizeof(prefix), "%s %s", __hist_sz[i], class_sz);
+			hist_dump(&__hists[i][c], prefix, file);
+		}
+	}
+}
+
+void metrics_report_resources(const char *name)
+{
+	printf("***** RESOURCES: %s *****\n", name);
+	printf("%3s %10s %10s %10s %9s %10s %7s %7s %10s\n", "id",
+			"acquires", "contended", "hold", "mean_hold", "blocked",
+			"max_wq", "mean_wq", "inversion");
+
+	for (int i = 0; i < NR_RESOURCES; i++) {
+		struct resource_metrics *r = __resources + i;
+
+		if (!r->acquires && !r->contended) continue;
+
+		__waiters_change(i, 0);
+		printf("%3d %10llu %10llu %10llu %9.2f %10llu %7u %7.2f %10llu\n", i,
+				r->acquires, r->contended, r->hold,
+				r->acquires ? (double)r->hold / r->acquires : 0.0,
+				r->blocked, r->max_waiters,
+				ticks ? (double)r->waiters_area / ticks : 0.0,
+				r->inversion);
+	}
+	printf("\npriority inversion %llu ticks (%.2f%% of %u ticks)\n\n",
+			__inversion, ticks ? 100.0 * __inversion / ticks : 0.0, ticks);
+}
+
+void metrics_report_shares(const char *name)
+{
+	printf("***** SHARES: %s *****\n", name);
+	printf("windows %u of %u ticks\n", __nr_windows, share_window);
+	if (__nr_windows) {
+		printf("share error mean %.4f, p50 %.3f, p90 %.3f, p99 %.3f, max %.4f\n",
+				__window_error_sum / __nr_windows,
+				hist_percentile(&__window_errors, 50) / 1000.0,
+				hist_percentile(&__window_errors, 90) / 1000.0,
+				hist_percentile(&__window_errors, 99) / 1000.0,
+				__window_error_max);
+	}
+	printf("\n");
+}
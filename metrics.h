@@ -0,0 +1,113 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <stdio.h>
+
+#include "types.h"
+
+struct process;
+
+/**
+ * Tick value denoting "not yet happened"
+ */
+#define METRICS_NONE	(~0U)
+
+/***********************************************************************
+ * struct proc_metrics
+ *
+ * DESCRIPTION
+ *   Scheduling metrics of an exited process. The framework fills in the
+ *   per-process counters in struct process as the simulation goes, and
+ *   they are folded into this at exit.
+ *
+ *   Each tick between the arrival and the completion of a process is spent
+ *   either running, blocked (the '=' event), waiting in the waitqueue of a
+ *   resource, sleeping for I/O, switching into the process (the '~'
+ *   event), or ready. The ready ticks are derived from the others.
+ */
+struct proc_metrics {
+	unsigned int pid;
+	unsigned int prio;			/* Original priority */
+	unsigned int arrival;		/* Tick the process was forked */
+	unsigned int first_run;		/* Tick the process was dispatched first */
+	unsigned int completion;	/* Tick the process exited */
+	unsigned int deadline;		/* Tick to complete by. 0 if none */
+	unsigned int run;			/* Ticks spent running */
+	unsigned int ready;			/* Ticks spent ready to run */
+	unsigned int blocked;		/* Ticks blocked while acquiring resources */
+	unsigned int resource_wait;	/* Ticks spent in resource waitqueues */
+	unsigned int io;			/* Ticks spent sleeping for I/O */
+	unsigned int switches;		/* # of times switched in */
+	unsigned int switch_overhead;
+								/* Ticks spent switching into the process */
+};
+
+static inline unsigned int metrics_turnaround(struct proc_metrics *m)
+{
+	return m->completion - m->arrival;
+}
+
+static inline unsigned int metrics_response(struct proc_metrics *m)
+{
+	return m->first_run - m->arrival;
+}
+
+/**
+ * True if the program was started with -m option. Then the metrics of
+ * each process are kept until the end and printed as a table
+ */
+extern bool metrics;
+
+/**
+ * True if the program was started with -H option. Then the percentiles of
+ * waiting, response, and resource blocking time are printed at exit
+ */
+extern bool histograms;
+
+/**
+ * True if the program was started with -R option. Then the contention on
+ * each resource and priority inversions are analyzed and printed at exit
+ */
+extern bool resource_metrics;
+
+/**
+ * Length of the windows to measure CPU shares over (-w option). 0 if the
+ * shares are not measured. See metrics_report_shares()
+ */
+extern unsigned int share_window;
+
+void metrics_fork(struct process *p);
+void metrics_dispatch(struct process *p, struct process *prev);
+void metrics_run(struct process *p);
+void metrics_block(struct process *p, int resource_id);
+void metrics_acquire(struct process *p, int resource_id);
+void metrics_release(int resource_id);
+void metrics_switch_overhead(struct process *p);
+void metrics_wakeup(struct process *p);
+void metrics_sleep(struct process *p);
+void metrics_io_wakeup(struct process *p);
+void metrics_exit(struct process *p);
+void metrics_share_window(void);
+
+void metrics_report(const char *name);
+void metrics_report_histograms(const char *name);
+void metrics_dump_histograms(FILE *file);
+void metrics_report_resources(const char *name);
+void metrics_report_shares(const char *name);
+
+#endif
@@ -17,7 +17,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <math.h>
 
 #include "types.h"
 #include "list_head.h"
@@ -42,6 +44,14 @@ extern struct list_head readyqueue;
 extern struct resource resources[NR_RESOURCES];
 
 
+/**
+ * Structure-of-arrays mirror of the ready queue. Put processes into and
+ * take them out of @readyqueue with ready_enqueue() and ready_dequeue()
+ * to keep it in sync. See soa.h
+ */
+#include "soa.h"
+
+
 /**
  * Monotonically increasing ticks
  */
@@ -54,6 +64,31 @@ extern unsigned int ticks;
 extern bool quiet;
 
 
+/**
+ * Report scheduling metrics at exit. True if the program was started with
+ * -m option. See metrics.h
+ */
+#include "metrics.h"
+
+
+/**
+ * Binary heap for the schedulers picking the process with the minimum key
+ */
+#include "heap.h"
+
+
+/**
+ * Log-linear histograms for the distributions reported at exit
+ */
+#include "hist.h"
+
+
+/**
+ * Seeded pseudo-random numbers for the randomized schedulers
+ */
+#include "prng.h"
+
+
 /***********************************************************************
  * Default FCFS resource acquision function
  *
@@ -133,7 +168,7 @@ void fcfs_release(int resource_id)
 		 * Put the waiter process into ready queue. The framework will
 		 * do the rest.
 		 */
-		list_add_tail(&waiter->list, &readyqueue);
+		ready_enqueue(waiter);
 	}
 }
 
@@ -191,7 +226,7 @@ pick_next:
 		 * instead of list_del() to maintain the list head tidy. Otherwise,
 		 * the framework will complain (assert) on process exit.
 		 */
-		list_del_init(&next->list);
+		ready_dequeue(next);
 	}	
 
 	/* Return the next process to run */
@@ -235,6 +270,12 @@ static struct process *sjf_schedule(void){
 	pick_next:
 	// readyqueue로 이동해서 비어있지 않다면 실행됨
 	if (!list_empty(&readyqueue)) {
+		if (soa) {
+			next = ready_table_entry(soa_argmin(ready_table.lifespan, NULL,
+						ready_table.seq, ready_table.nr));
+			goto found;
+		}
+
 		// readyqueue에 process의 순번대로 next에 넣음
 		next = list_first_entry(&readyqueue, struct process, list);	
 
@@ -244,7 +285,8 @@ static struct process *sjf_schedule(void){
 			if(next->lifespan > cur->lifespan)
 				next = cur;
 		}
-		list_del_init(&next->list); //readyqueue에서 process 분리
+	found:
+		ready_dequeue(next); //readyqueue에서 process 분리
 	}	
 	
 	return next;
@@ -281,12 +323,18 @@ static struct process *srtf_schedule(void){
 	
 	// 현재 process를 readyqueue 제일 끝에 붙임
 	if (current->age < current->lifespan) {
-			list_add_tail(&current->list,&readyqueue);
+			ready_enqueue(current);
 	}
 	
 	// 다음 실행할 process 분류 -> 남은 lifespan이 제일 짧은 process
 	pick_next:
 	if (!list_empty(&readyqueue)) {
+		if (soa) {
+			next = ready_table_entry(soa_argmin(ready_table.lifespan,
+						ready_table.age, ready_table.seq, ready_table.nr));
+			goto found;
+		}
+
 		// readyqueue에 process의 순번대로 next에 넣음
 		next = list_first_entry(&readyqueue, struct process, list);
 
@@ -296,7 +344,8 @@ static struct process *srtf_schedule(void){
 				next = cur;
 		}
 
-		list_del_init(&next->list); //readyqueue에서 process 분리
+	found:
+		ready_dequeue(next); //readyqueue에서 process 분리
 	}
 	return next;
 }
@@ -331,14 +380,14 @@ static struct process *rr_schedule(void){
 	if (current->age < current->lifespan) {
 		// current가 한번 실행하고 다시 readyqueue에 붙임
 		// 한번만 실행했으므로 time quantum인 1 tick 만족
-		list_add_tail(&current->list,&readyqueue);
+		ready_enqueue(current);
 	}
 
 	pick_next:
 	if (!list_empty(&readyqueue)) {
 		// fifo처럼 차례로 실행
 		next = list_first_entry(&readyqueue, struct process, list);
-		list_del_init(&next->list);
+		ready_dequeue(next);
 	}
 	return next;
 }
@@ -376,13 +425,13 @@ void prio_release(int resource_id){
 		assert(waiter->status == PROCESS_WAIT);
 		list_del_init(&waiter->list);
 		waiter->status = PROCESS_READY;
-		list_add_tail(&waiter->list, &readyqueue);
+		ready_enqueue(waiter);
 	}
 }
 
 static struct process *prio_schedule(void){  
 	struct process *next = NULL;
-	dump_status();
+	// dump_status();
 	// acquire 1 0 2 -> 0번 했을 때 resource#1을 2 tick 사용
 	struct process *cur = NULL;
 	struct process *curn = NULL;
@@ -393,13 +442,19 @@ static struct process *prio_schedule(void){
 	}
 	
 	if (current->age < current->lifespan) {
-		list_add_tail(&current->list,&readyqueue);
+		ready_enqueue(current);
 	}
 	
 	// 다음에 실행할 process 분류 -> 우선순위가 높은 process
 	pick_next:
 	// readyqueu가 비어있지 않다면 실행
 	if (!list_empty(&readyqueue)) {
+		if (soa) {
+			next = ready_table_entry(soa_argmax(ready_table.prio,
+						ready_table.seq, ready_table.nr));
+			goto found;
+		}
+
 		// readyqueue에 있는 process중에 priority가 제일 높은 process를 next에 넣어줌
 		next = list_first_entry(&readyqueue, struct process, list);
 		list_for_each_entry_safe(cur,curn,&readyqueue,list){
@@ -407,7 +462,8 @@ static struct process *prio_schedule(void){
 				next = cur;
 			}
 		}
-		list_del_init(&next->list);
+	found:
+		ready_dequeue(next);
 	}
 	return next;
 }
@@ -430,7 +486,7 @@ struct scheduler prio_scheduler = {
 
 static struct process *pa_schedule(void){
 	struct process *next = NULL;
-	dump_status();
+	// dump_status();
 	struct process *cur = NULL;
 	struct process *curn = NULL;
 
@@ -440,14 +496,21 @@ static struct process *pa_schedule(void){
 
 	// 실행중인 process의 priority를 원래 priority로 되돌려 놓음
 	if (current->age < current->lifespan) { 
-		list_add_tail(&current->list,&readyqueue);
 		current->prio = current->prio_orig;
+		ready_enqueue(current);
 	}
 
 	pick_next:
 		if (!list_empty(&readyqueue)) {
 			// readyqueue에 있는 모든 process는 priority boost 1씩 받는다.
 			// scheduling될 process는 priority가 높은 process
+			if (soa) {
+				soa_add(ready_table.prio, ready_table.nr, 1);
+				next = ready_table_entry(soa_argmax(ready_table.prio,
+							ready_table.seq, ready_table.nr));
+				goto found;
+			}
+
 			next = list_first_entry(&readyqueue, struct process, list);
 			list_for_each_entry_safe(cur,curn,&readyqueue,list){
 				cur->prio++;
@@ -456,7 +519,8 @@ static struct process *pa_schedule(void){
 					next = cur;
 				}
 			}
-			list_del_init(&next->list);
+		found:
+			ready_dequeue(next);
 		}	
 
 	return next;
@@ -508,7 +572,7 @@ void pcp_release(int resource_id)
 		assert(waiter->status == PROCESS_WAIT);
 		list_del_init(&waiter->list);
 		waiter->status = PROCESS_READY;
-		list_add_tail(&waiter->list, &readyqueue);
+		ready_enqueue(waiter);
 	}
 }
 
@@ -537,6 +601,7 @@ bool pip_acquire(int resource_id){
 		return true;
 	}
 	r->owner->prio = current->prio;
+	ready_update(r->owner);
 	current->status = PROCESS_WAIT;
 	list_add_tail(&current->list, &r->waitqueue);
 	return false;
@@ -564,7 +629,7 @@ void pip_release(int resource_id){
 		assert(waiter->status == PROCESS_WAIT);
 		list_del_init(&waiter->list);
 		waiter->status = PROCESS_READY;
-		list_add_tail(&waiter->list, &readyqueue);
+		ready_enqueue(waiter);
 	}
 }
 
@@ -578,3 +643,1882 @@ struct scheduler pip_scheduler = {
 	 * Ditto
 	 */
 };
+
+
+
+/***********************************************************************
+ * Completely Fair Scheduler
+ *
+ * Processes are sorted in a red-black tree by their virtual runtime, the
+ * ticks they ran scaled by NICE_0_WEIGHT / weight, and the leftmost one
+ * runs next. The running process is out of the tree, and is put back when
+ * preempted. It is preempted when it has run out of its slice, a share of
+ * the scheduling period proportional to its weight, or when the leftmost
+ * one lags behind by more than the wakeup granularity.
+ *
+ * Priorities are mapped linearly onto nice values so that prio 0 is
+ * nice 19 and MAX_PRIO is nice -20.
+ ***********************************************************************/
+#define NICE_0_WEIGHT	1024
+
+/**
+ * A tick of a nice-0 process in vruntime. Keep it small enough for EEVDF
+ * to multiply vruntimes by the total weight without overflowing
+ */
+#define VRUNTIME_TICK	(1ULL << 16)
+
+/* sched_prio_to_weight[] of Linux for nice -20 .. 19 */
+static const unsigned int __nice_to_weight[40] = {
+	88761, 71755, 56483, 46273, 36291,
+	29154, 23254, 18705, 14949, 11916,
+	9548, 7620, 6100, 4904, 3906,
+	3121, 2501, 1991, 1586, 1277,
+	1024, 820, 655, 526, 423,
+	335, 272, 215, 172, 137,
+	110, 87, 70, 56, 45,
+	36, 29, 23, 18, 15,
+};
+
+/**
+ * Tunables in ticks. The defaults follow those of Linux, taking a tick as
+ * a millisecond
+ */
+static unsigned int cfs_latency = 6;
+static unsigned int cfs_min_granularity = 1;
+static unsigned int cfs_wakeup_granularity = 1;
+
+static struct {
+	struct rb_root tasks;
+	unsigned int nr;			/* # of processes in @tasks */
+	unsigned long long load;	/* Sum of their weights */
+	unsigned long long min_vruntime;
+} cfs_rq;
+
+static unsigned int prio_to_weight(unsigned int prio)
+{
+	if (prio > MAX_PRIO) prio = MAX_PRIO;
+	return __nice_to_weight[39 - prio * 40 / (MAX_PRIO + 1)];
+}
+
+static inline struct process *se_process(struct rb_node *node)
+{
+	return rb_entry(node, struct process, se.run_node);
+}
+
+static bool cfs_less(const struct rb_node *a, const struct rb_node *b)
+{
+	return se_process((struct rb_node *)a)->se.vruntime <
+			se_process((struct rb_node *)b)->se.vruntime;
+}
+
+/* Scale whole ticks, so that a slice is exactly as long as its ticks */
+static inline unsigned long long calc_delta_fair(unsigned int delta,
+		struct process *p)
+{
+	return delta * (VRUNTIME_TICK * NICE_0_WEIGHT / p->se.weight);
+}
+
+/* Period to run every process once, stretched when there are too many */
+static unsigned int __sched_period(unsigned int nr)
+{
+	if (nr > cfs_latency / cfs_min_granularity) {
+		return nr * cfs_min_granularity;
+	}
+	return cfs_latency;
+}
+
+/* Slice of @p, which is not in the tree */
+static unsigned int cfs_slice(struct process *p)
+{
+	unsigned long long load = cfs_rq.load + p->se.weight;
+	unsigned int slice = __sched_period(cfs_rq.nr + 1) * p->se.weight / load;
+
+	return slice > cfs_min_granularity ? slice : cfs_min_granularity;
+}
+
+static void __enqueue_entity(struct process *p)
+{
+	rb_add(&p->se.run_node, &cfs_rq.tasks, cfs_less, NULL);
+	cfs_rq.nr++;
+	cfs_rq.load += p->se.weight;
+}
+
+static void __dequeue_entity(struct process *p)
+{
+	rb_erase(&p->se.run_node, &cfs_rq.tasks, NULL);
+	cfs_rq.nr--;
+	cfs_rq.load -= p->se.weight;
+}
+
+/* Charge the ticks @p ran since the last accounting */
+static void __update_curr(struct process *p)
+{
+	p->se.vruntime += calc_delta_fair(p->age - p->se.last_age, p);
+	p->se.last_age = p->age;
+}
+
+/* Advance min_vruntime monotonically to the smallest vruntime around */
+static void __update_min_vruntime(struct process *curr)
+{
+	struct rb_node *left = rb_first(&cfs_rq.tasks);
+	unsigned long long vruntime;
+
+	if (curr) {
+		vruntime = curr->se.vruntime;
+		if (left && se_process(left)->se.vruntime < vruntime) {
+			vruntime = se_process(left)->se.vruntime;
+		}
+	} else if (left) {
+		vruntime = se_process(left)->se.vruntime;
+	} else {
+		return;
+	}
+
+	if (vruntime > cfs_rq.min_vruntime) cfs_rq.min_vruntime = vruntime;
+}
+
+/**
+ * Do not let a process woken up after a long sleep monopolize the
+ * processor. It is credited half the latency at most
+ */
+static void __place_entity(struct process *p)
+{
+	unsigned long long thresh = cfs_latency * VRUNTIME_TICK / 2;
+
+	if (cfs_rq.min_vruntime > thresh &&
+			p->se.vruntime < cfs_rq.min_vruntime - thresh) {
+		p->se.vruntime = cfs_rq.min_vruntime - thresh;
+	}
+}
+
+static bool __check_preempt(struct process *curr)
+{
+	struct rb_node *left = rb_first(&cfs_rq.tasks);
+	unsigned int ran = curr->age - curr->se.slice_start;
+	struct process *first;
+
+	if (!left) return false;
+	if (ran >= cfs_slice(curr)) return true;
+	if (ran < cfs_min_granularity) return false;
+
+	first = se_process(left);
+	return curr->se.vruntime >
+			first->se.vruntime + calc_delta_fair(cfs_wakeup_granularity, first);
+}
+
+static int cfs_initialize(void)
+{
+	if (!cfs_min_granularity || cfs_latency < cfs_min_granularity) {
+		fprintf(stderr, "cfs.min_granularity should be in [1, cfs.latency]\n");
+		return -1;
+	}
+
+	INIT_RB_ROOT(&cfs_rq.tasks);
+	cfs_rq.nr = 0;
+	cfs_rq.load = 0;
+	cfs_rq.min_vruntime = 0;
+	return 0;
+}
+
+static void cfs_forked(struct process *p)
+{
+	RB_CLEAR_NODE(&p->se.run_node);
+	p->se.weight = prio_to_weight(p->prio);
+	p->se.last_age = p->se.slice_start = 0;
+
+	/* New processes start after a slice so as not to preempt right away */
+	p->se.vruntime = cfs_rq.min_vruntime + calc_delta_fair(cfs_slice(p), p);
+}
+
+static struct process *cfs_schedule(void)
+{
+	struct process *next, *p, *tmp;
+	bool runnable = current && current->status != PROCESS_WAIT &&
+			current->age < current->lifespan;
+
+	if (current) __update_curr(current);
+	__update_min_vruntime(runnable ? current : NULL);
+
+	/* Move the forked and woken up processes into the tree */
+	list_for_each_entry_safe(p, tmp, &readyqueue, list) {
+		ready_dequeue(p);
+		__place_entity(p);
+		__enqueue_entity(p);
+	}
+
+	if (runnable) {
+		if (!__check_preempt(current)) return current;
+		__enqueue_entity(current);
+	}
+
+	if (rb_empty(&cfs_rq.tasks)) return NULL;
+
+	next = se_process(rb_first(&cfs_rq.tasks));
+	__dequeue_entity(next);
+	next->se.slice_start = next->age;
+
+	return next;
+}
+
+struct scheduler cfs_scheduler = {
+	.name = "Completely Fair",
+	.acquire = fcfs_acquire,
+	.release = fcfs_release,
+	.initialize = cfs_initialize,
+	.forked = cfs_forked,
+	.schedule = cfs_schedule,
+};
+
+
+
+
+/***********************************************************************
+ * EEVDF scheduler
+ *
+ * Earliest Eligible Virtual Deadline First. Each process requests slices
+ * of eevdf.base_slice ticks, or of those given with the slice property in
+ * the script, and each request has the virtual deadline of vruntime +
+ * slice / weight. A process is eligible when it has not received its share
+ * yet, i.e., its vruntime is not past the weighted average V of all the
+ * runnable processes. Among the eligible ones, the one with the earliest
+ * deadline runs next.
+ *
+ * The tree is sorted by the deadline and augmented with the minimum
+ * vruntime of each subtree, so the leftmost eligible one is found in
+ * O(log N). V is kept as the weighted sum of vruntimes relative to
+ * min_vruntime. The current process runs until its request is fulfilled
+ * unless others wake up. A process going to wait for a resource keeps its
+ * lag V - vruntime and is placed back with the same lag when woken up.
+ ***********************************************************************/
+static unsigned int eevdf_base_slice = 3;
+
+static struct {
+	struct rb_root tasks;
+	long long load;				/* Sum of the weights in @tasks */
+	long long sum_wkey;			/* Sum of weight * (vruntime - min_vruntime) */
+	unsigned long long min_vruntime;
+} eevdf_rq;
+
+static inline unsigned long long __vslice(struct process *p)
+{
+	return calc_delta_fair(p->slice ? p->slice : eevdf_base_slice, p);
+}
+
+static inline long long __entity_key(unsigned long long vruntime)
+{
+	return (long long)(vruntime - eevdf_rq.min_vruntime);
+}
+
+static bool eevdf_less(const struct rb_node *a, const struct rb_node *b)
+{
+	return se_process((struct rb_node *)a)->se.deadline <
+			se_process((struct rb_node *)b)->se.deadline;
+}
+
+static void __eevdf_update(struct rb_node *node)
+{
+	struct process *p = se_process(node);
+	unsigned long long min = p->se.vruntime;
+
+	if (node->left && se_process(node->left)->se.min_vruntime < min) {
+		min = se_process(node->left)->se.min_vruntime;
+	}
+	if (node->right && se_process(node->right)->se.min_vruntime < min) {
+		min = se_process(node->right)->se.min_vruntime;
+	}
+	p->se.min_vruntime = min;
+}
+
+static const struct rb_augment __eevdf_augment = {
+	.update = __eevdf_update,
+};
+
+static void __eevdf_enqueue(struct process *p)
+{
+	rb_add(&p->se.run_node, &eevdf_rq.tasks, eevdf_less, &__eevdf_augment);
+	eevdf_rq.load += p->se.weight;
+	eevdf_rq.sum_wkey += p->se.weight * __entity_key(p->se.vruntime);
+}
+
+static void __eevdf_dequeue(struct process *p)
+{
+	rb_erase(&p->se.run_node, &eevdf_rq.tasks, &__eevdf_augment);
+	eevdf_rq.load -= p->se.weight;
+	eevdf_rq.sum_wkey -= p->se.weight * __entity_key(p->se.vruntime);
+}
+
+/* Weighted sum of the keys and the load of the tree and @curr if any */
+static void __eevdf_avg(struct process *curr, long long *avg, long long *load)
+{
+	*avg = eevdf_rq.sum_wkey;
+	*load = eevdf_rq.load;
+	if (curr) {
+		*avg += curr->se.weight * __entity_key(curr->se.vruntime);
+		*load += curr->se.weight;
+	}
+}
+
+/* V relative to min_vruntime */
+static long long __eevdf_avg_key(struct process *curr)
+{
+	long long avg, load;
+
+	__eevdf_avg(curr, &avg, &load);
+	return load ? avg / load : 0;
+}
+
+/* Whether @vruntime is not past V, tested without dividing */
+static bool __eligible(unsigned long long vruntime)
+{
+	return eevdf_rq.sum_wkey >= __entity_key(vruntime) * eevdf_rq.load;
+}
+
+static void __eevdf_update_min_vruntime(struct process *curr)
+{
+	unsigned long long vruntime;
+
+	if (curr) {
+		vruntime = curr->se.vruntime;
+		if (!rb_empty(&eevdf_rq.tasks) &&
+				se_process(eevdf_rq.tasks.node)->se.min_vruntime < vruntime) {
+			vruntime = se_process(eevdf_rq.tasks.node)->se.min_vruntime;
+		}
+	} else if (!rb_empty(&eevdf_rq.tasks)) {
+		vruntime = se_process(eevdf_rq.tasks.node)->se.min_vruntime;
+	} else {
+		return;
+	}
+
+	if (vruntime > eevdf_rq.min_vruntime) {
+		/* Rebase the keys in the sum */
+		eevdf_rq.sum_wkey -=
+				eevdf_rq.load * (long long)(vruntime - eevdf_rq.min_vruntime);
+		eevdf_rq.min_vruntime = vruntime;
+	}
+}
+
+/* Keep the lag of @p, which is leaving the runqueue */
+static void __eevdf_update_lag(struct process *p)
+{
+	long long lag = __eevdf_avg_key(p) - __entity_key(p->se.vruntime);
+	unsigned int slice = p->slice ? p->slice : eevdf_base_slice;
+	long long limit = calc_delta_fair(slice * 2, p);
+
+	if (lag > limit) lag = limit;
+	if (lag < -limit) lag = -limit;
+	p->se.vlag = lag;
+}
+
+/* Place @p joining the runqueue at V - lag, and give it a new request */
+static void __eevdf_place(struct process *p, struct process *curr)
+{
+	long long avg, load;
+	long long lag = p->se.vlag;
+
+	__eevdf_avg(curr, &avg, &load);
+
+	/* Inflate the lag so that it is preserved after @p joins V */
+	if (load) {
+		lag = lag * (load + p->se.weight) / load;
+	}
+	p->se.vruntime = eevdf_rq.min_vruntime + (load ? avg / load : 0) - lag;
+	p->se.deadline = p->se.vruntime + __vslice(p);
+	p->se.vlag = 0;
+}
+
+static struct process *__pick_eevdf(void)
+{
+	struct rb_node *node = eevdf_rq.tasks.node;
+
+	while (node) {
+		struct rb_node *left = node->left;
+
+		/* An eligible one with an earlier deadline is on the left */
+		if (left && __eligible(se_process(left)->se.min_vruntime)) {
+			node = left;
+			continue;
+		}
+		if (__eligible(se_process(node)->se.vruntime)) {
+			return se_process(node);
+		}
+		node = node->right;
+	}
+
+	/* Rounding may leave none eligible. Take the earliest deadline then */
+	return se_process(rb_first(&eevdf_rq.tasks));
+}
+
+static int eevdf_initialize(void)
+{
+	if (!eevdf_base_slice) {
+		fprintf(stderr, "eevdf.base_slice should be positive\n");
+		return -1;
+	}
+
+	INIT_RB_ROOT(&eevdf_rq.tasks);
+	eevdf_rq.load = 0;
+	eevdf_rq.sum_wkey = 0;
+	eevdf_rq.min_vruntime = 0;
+	return 0;
+}
+
+static void eevdf_forked(struct process *p)
+{
+	RB_CLEAR_NODE(&p->se.run_node);
+	p->se.weight = prio_to_weight(p->prio);
+	p->se.last_age = 0;
+	p->se.vlag = 0;
+}
+
+static struct process *eevdf_schedule(void)
+{
+	struct process *next, *p, *tmp;
+	bool runnable = current && current->status != PROCESS_WAIT &&
+			current->age < current->lifespan;
+	bool woken = !list_empty(&readyqueue);
+
+	if (current) __update_curr(current);
+	__eevdf_update_min_vruntime(runnable ? current : NULL);
+
+	if (current && current->status == PROCESS_WAIT) {
+		__eevdf_update_lag(current);
+	}
+
+	/* Place the forked and woken up processes with their lags */
+	list_for_each_entry_safe(p, tmp, &readyqueue, list) {
+		ready_dequeue(p);
+		__eevdf_place(p, runnable ? current : NULL);
+		__eevdf_enqueue(p);
+	}
+
+	if (runnable) {
+		if (current->se.vruntime >= current->se.deadline) {
+			/* The request is fulfilled. Make a new one */
+			current->se.deadline = current->se.vruntime + __vslice(current);
+		} else if (!woken) {
+			return current;
+		}
+		__eevdf_enqueue(current);
+	}
+
+	if (rb_empty(&eevdf_rq.tasks)) return NULL;
+
+	next = __pick_eevdf();
+	__eevdf_dequeue(next);
+
+	return next;
+}
+
+struct scheduler eevdf_scheduler = {
+	.name = "EEVDF",
+	.acquire = fcfs_acquire,
+	.release = fcfs_release,
+	.initialize = eevdf_initialize,
+	.forked = eevdf_forked,
+	.schedule = eevdf_schedule,
+};
+
+
+
+
+/***********************************************************************
+ * Multi-level feedback queue scheduler
+ *
+ * Processes start at the top level 0 and run the level with the smallest
+ * index first, round-robin within a level. Each level gives a process the
+ * quantum of mlfq.quantum << level ticks. A process that has used it up
+ * at a level, in one go or across several runs, is demoted to the next
+ * level. Every mlfq.boost ticks, all the processes are moved back to the
+ * top level so that long-running ones do not starve.
+ *
+ * Non-empty levels are marked in a bitmap, so picking the next one is a
+ * count of trailing zeros. A boost splices the queues into the top one,
+ * and the levels of the processes are brought up to date lazily by
+ * comparing their boost epochs.
+ ***********************************************************************/
+#define MLFQ_MAX_LEVELS	16
+
+static unsigned int mlfq_levels = 8;
+static unsigned int mlfq_quantum = 1;
+static unsigned int mlfq_boost = 100;
+
+static struct {
+	struct list_head queues[MLFQ_MAX_LEVELS];
+	unsigned int bitmap;		/* Bit i is set if @queues[i] is not empty */
+	unsigned int epoch;			/* Incremented on every boost */
+	unsigned int next_boost;	/* Tick to boost next */
+	unsigned int nr_boosts;
+
+	/* Occupancy of each level, integrated over ticks */
+	struct {
+		unsigned int nr;		/* # of processes queued */
+		unsigned int max;
+		unsigned int since;		/* Tick @nr changed last time */
+		unsigned long long area;
+		unsigned long long run;	/* Ticks run at the level */
+		unsigned long long demotions;
+								/* # of demotions into the level */
+	} stats[MLFQ_MAX_LEVELS];
+} mlfq;
+
+static inline unsigned int __mlfq_quantum(unsigned int level)
+{
+	return mlfq_quantum << level;
+}
+
+/* Level of @p, reset to the top level if boosted since it was set */
+static inline unsigned int __mlfq_level(struct process *p)
+{
+	if (p->mlfq.epoch != mlfq.epoch) {
+		p->mlfq.epoch = mlfq.epoch;
+		p->mlfq.level = 0;
+		p->mlfq.used = 0;
+	}
+	return p->mlfq.level;
+}
+
+static void __mlfq_occupy(unsigned int level, int delta)
+{
+	mlfq.stats[level].area +=
+			(unsigned long long)mlfq.stats[level].nr * (ticks - mlfq.stats[level].since);
+	mlfq.stats[level].since = ticks;
+	mlfq.stats[level].nr += delta;
+	if (mlfq.stats[level].nr > mlfq.stats[level].max) {
+		mlfq.stats[level].max = mlfq.stats[level].nr;
+	}
+}
+
+static void __mlfq_enqueue(struct process *p)
+{
+	unsigned int level = __mlfq_level(p);
+
+	list_add_tail(&p->list, mlfq.queues + level);
+	mlfq.bitmap |= 1U << level;
+	__mlfq_occupy(level, 1);
+}
+
+static struct process *__mlfq_dequeue_first(void)
+{
+	unsigned int level = __builtin_ctz(mlfq.bitmap);
+	struct process *p = list_first_entry(mlfq.queues + level, struct process, list);
+
+	list_del_init(&p->list);
+	if (list_empty(mlfq.queues + level)) mlfq.bitmap &= ~(1U << level);
+	__mlfq_occupy(level, -1);
+
+	return p;
+}
+
+static void __mlfq_boost(void)
+{
+	for (unsigned int level = 1; level < mlfq_levels; level++) {
+		if (list_empty(mlfq.queues + level)) continue;
+
+		__mlfq_occupy(0, mlfq.stats[level].nr);
+		__mlfq_occupy(level, -(int)mlfq.stats[level].nr);
+		list_splice_tail_init(mlfq.queues + level, mlfq.queues);
+	}
+	if (mlfq.bitmap) mlfq.bitmap = 1;
+
+	mlfq.epoch++;
+	mlfq.nr_boosts++;
+}
+
+static int mlfq_initialize(void)
+{
+	if (!mlfq_levels || mlfq_levels > MLFQ_MAX_LEVELS) {
+		fprintf(stderr, "mlfq.levels should be in [1, %d]\n", MLFQ_MAX_LEVELS);
+		return -1;
+	}
+	if (!mlfq_quantum) {
+		fprintf(stderr, "mlfq.quantum should be positive\n");
+		return -1;
+	}
+
+	for (int i = 0; i < MLFQ_MAX_LEVELS; i++) {
+		INIT_LIST_HEAD(mlfq.queues + i);
+	}
+	mlfq.next_boost = mlfq_boost;
+	return 0;
+}
+
+static void mlfq_finalize(void)
+{
+	if (!metrics) return;
+
+	printf("***** MLFQ LEVELS *****\n");
+	printf("%5s %8s %10s %10s %10s %10s\n", "level", "quantum",
+			"avg_queued", "max_queued", "run_ticks", "demotions");
+	for (unsigned int level = 0; level < mlfq_levels; level++) {
+		__mlfq_occupy(level, 0);
+		printf("%5u %8u %10.2f %10u %10llu %10llu\n", level,
+				__mlfq_quantum(level),
+				ticks ? (double)mlfq.stats[level].area / ticks : 0.0,
+				mlfq.stats[level].max, mlfq.stats[level].run,
+				mlfq.stats[level].demotions);
+	}
+	printf("\nboosts %u\n\n", mlfq.nr_boosts);
+}
+
+static void mlfq_forked(struct process *p)
+{
+	p->mlfq.epoch = mlfq.epoch;
+	p->mlfq.level = 0;
+	p->mlfq.used = 0;
+}
+
+static struct process *mlfq_schedule(void)
+{
+	struct process *p, *tmp;
+	bool runnable = current && current->status != PROCESS_WAIT &&
+			current->age < current->lifespan;
+
+	/* Charge the tick that @current ran at its level */
+	if (current && current->status != PROCESS_WAIT) {
+		unsigned int level = __mlfq_level(current);
+
+		current->mlfq.used++;
+		mlfq.stats[level].run++;
+	}
+
+	if (mlfq_boost && ticks >= mlfq.next_boost) {
+		__mlfq_boost();
+		mlfq.next_boost = ticks + mlfq_boost;
+	}
+
+	/* Queue up the forked and woken up processes at their levels */
+	list_for_each_entry_safe(p, tmp, &readyqueue, list) {
+		ready_dequeue(p);
+		__mlfq_enqueue(p);
+	}
+
+	if (runnable) {
+		unsigned int level = __mlfq_level(current);
+
+		if (current->mlfq.used >= __mlfq_quantum(level)) {
+			/* Used up the quantum. Demote it unless at the bottom */
+			if (level + 1 < mlfq_levels) {
+				current->mlfq.level = ++level;
+				mlfq.stats[level].demotions++;
+			}
+			current->mlfq.used = 0;
+			__mlfq_enqueue(current);
+		} else if (mlfq.bitmap & ((1U << level) - 1)) {
+			/* Preempted by a process at a higher level */
+			__mlfq_enqueue(current);
+		} else {
+			return current;
+		}
+	}
+
+	if (!mlfq.bitmap) return NULL;
+
+	return __mlfq_dequeue_first();
+}
+
+struct scheduler mlfq_scheduler = {
+	.name = "Multi-Level Feedback Queue",
+	.acquire = fcfs_acquire,
+	.release = fcfs_release,
+	.initialize = mlfq_initialize,
+	.finalize = mlfq_finalize,
+	.forked = mlfq_forked,
+	.schedule = mlfq_schedule,
+};
+
+
+
+
+/***********************************************************************
+ * Earliest deadline first scheduler
+ *
+ * The ready process with the earliest deadline runs next, preempting the
+ * current one if its deadline is later. Processes without deadlines come
+ * after all those with ones, first-come first-served.
+ *
+ * When edf.admission is set, a process with a deadline is admitted at fork
+ * only if all admitted processes can still meet their deadlines with it,
+ * that is, for every admitted deadline d not earlier than its one, the
+ * remaining work of the processes due by d fits in before d. Blocking on
+ * resources is not accounted for. Rejected ones are set aside and never
+ * run, so they do not show up in the metrics.
+ ***********************************************************************/
+static unsigned int edf_admission = 0;
+
+static struct heap edf_rq = HEAP_INIT;
+static LIST_HEAD(edf_rejected);
+static unsigned int edf_nr_rejected = 0;
+
+/* Processes admitted with deadlines and not exited yet */
+static struct process **edf_admitted = NULL;
+static size_t edf_nr_admitted = 0;
+static size_t edf_max_admitted = 0;
+
+static inline unsigned long long __edf_key(struct process *p)
+{
+	return p->deadline ? p->deadline : ~0ULL;
+}
+
+/* Index of the first admitted process due later than @deadline */
+static size_t __edf_upper_bound(unsigned int deadline)
+{
+	size_t lo = 0, hi = edf_nr_admitted;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (edf_admitted[mid]->deadline <= deadline) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/* Whether every admitted process still meets its deadline along with @p */
+static bool __edf_admissible(struct process *p)
+{
+	unsigned long long demand = ticks;
+	bool admissible = true;
+	size_t pos, i;
+
+	if (edf_nr_admitted == edf_max_admitted) {
+		edf_max_admitted = edf_max_admitted ? edf_max_admitted * 2 : 64;
+		edf_admitted = realloc(edf_admitted,
+				sizeof(*edf_admitted) * edf_max_admitted);
+		assert(edf_admitted);
+	}
+
+	/* Insert @p into the array kept sorted by the deadline */
+	pos = __edf_upper_bound(p->deadline);
+	memmove(edf_admitted + pos + 1, edf_admitted + pos,
+			sizeof(*edf_admitted) * (edf_nr_admitted - pos));
+	edf_admitted[pos] = p;
+
+	for (i = 0; i <= edf_nr_admitted; i++) {
+		struct process *q = edf_admitted[i];
+
+		demand += q->lifespan - q->age;
+		if (i >= pos && demand > q->deadline) {
+			admissible = false;
+			break;
+		}
+	}
+
+	if (admissible) {
+		edf_nr_admitted++;
+	} else {
+		/* Take @p back out */
+		memmove(edf_admitted + pos, edf_admitted + pos + 1,
+				sizeof(*edf_admitted) * (edf_nr_admitted - pos));
+	}
+	return admissible;
+}
+
+static int edf_initialize(void)
+{
+	INIT_LIST_HEAD(&edf_rejected);
+	edf_nr_rejected = 0;
+	return 0;
+}
+
+static void edf_finalize(void)
+{
+	heap_destroy(&edf_rq);
+	free(edf_admitted);
+	edf_admitted = NULL;
+	edf_nr_admitted = edf_max_admitted = 0;
+
+	if (!metrics || !edf_admission) return;
+
+	printf("***** EDF *****\n");
+	printf("rejected %u processes\n\n", edf_nr_rejected);
+}
+
+static void edf_forked(struct process *p)
+{
+	if (!edf_admission || !p->deadline) return;
+	if (__edf_admissible(p)) return;
+
+	ready_dequeue(p);
+	list_add_tail(&p->list, &edf_rejected);
+	edf_nr_rejected++;
+}
+
+static void edf_exiting(struct process *p)
+{
+	size_t i;
+
+	if (!edf_admission || !p->deadline) return;
+
+	/* Keep the array sorted. @p is among those of the same deadline */
+	for (i = __edf_upper_bound(p->deadline); i > 0; i--) {
+		if (edf_admitted[i - 1] != p) continue;
+
+		edf_nr_admitted--;
+		memmove(edf_admitted + i - 1, edf_admitted + i,
+				sizeof(*edf_admitted) * (edf_nr_admitted - i + 1));
+		break;
+	}
+}
+
+/**
+ * Pick the process with the minimum @key from the heap runqueue @rq after
+ * moving the newly ready processes into it. The current process keeps
+ * running unless some process has a strictly smaller key
+ */
+static struct process *__heap_schedule(struct heap *rq,
+		unsigned long long (*key)(struct process *))
+{
+	struct process *p, *tmp;
+	bool runnable = current && current->status != PROCESS_WAIT &&
+			current->age < current->lifespan;
+
+	list_for_each_entry_safe(p, tmp, &readyqueue, list) {
+		ready_dequeue(p);
+		heap_push(rq, key(p), p);
+	}
+
+	if (runnable) {
+		if (heap_empty(rq) || heap_peek_key(rq) >= key(current)) {
+			return current;
+		}
+		heap_push(rq, key(current), current);
+	}
+
+	return heap_pop(rq);
+}
+
+static struct process *edf_schedule(void)
+{
+	return __heap_schedule(&edf_rq, __edf_key);
+}
+
+struct scheduler edf_scheduler = {
+	.name = "Earliest Deadline First",
+	.acquire = fcfs_acquire,
+	.release = fcfs_release,
+	.initialize = edf_initialize,
+	.finalize = edf_finalize,
+	.forked = edf_forked,
+	.exiting = edf_exiting,
+	.schedule = edf_schedule,
+};
+
+
+
+
+/***********************************************************************
+ * Rate-monotonic scheduler
+ *
+ * Periodic processes have fixed priorities by their periods; the shorter
+ * the period, the higher the priority. Ready jobs are kept in a heap keyed
+ * by the period, and a job preempts the current one only if its period is
+ * strictly shorter. One-shot processes run in the background, first-come
+ * first-served.
+ *
+ * With -m, the task set is checked at exit against the Liu and Layland
+ * utilization bound and by the exact response-time analysis.
+ ***********************************************************************/
+static struct heap rm_rq = HEAP_INIT;
+
+/* Periodic tasks seen so far, one per pid */
+struct rm_task {
+	unsigned int pid;
+	unsigned int period;
+	unsigned int wcet;
+	unsigned int deadline;		/* Relative to the release */
+};
+static struct rm_task *rm_tasks = NULL;
+static unsigned int rm_nr_tasks = 0;
+static unsigned int rm_max_tasks = 0;
+
+static inline unsigned long long __rm_key(struct process *p)
+{
+	return p->period ? p->period : ~0ULL;
+}
+
+static void rm_forked(struct process *p)
+{
+	struct rm_task *t;
+	unsigned int i;
+
+	if (!p->period) return;
+
+	for (i = 0; i < rm_nr_tasks; i++) {
+		if (rm_tasks[i].pid == p->pid) return;
+	}
+
+	if (rm_nr_tasks == rm_max_tasks) {
+		rm_max_tasks = rm_max_tasks ? rm_max_tasks * 2 : 16;
+		rm_tasks = realloc(rm_tasks, sizeof(*rm_tasks) * rm_max_tasks);
+		assert(rm_tasks);
+	}
+	t = rm_tasks + rm_nr_tasks++;
+	t->pid = p->pid;
+	t->period = p->period;
+	t->wcet = p->wcet ? p->wcet : p->lifespan;
+	t->deadline = p->deadline - ticks;
+}
+
+/**
+ * Worst-case response time of @t, iterating R = C + sum(ceil(R / Tj) * Cj)
+ * over the tasks j with periods not longer than that of @t. Returns 0 if
+ * it exceeds the deadline of @t
+ */
+static unsigned long long __rm_response_time(struct rm_task *t)
+{
+	unsigned long long r = t->wcet, prev = 0;
+
+	while (r != prev && r <= t->deadline) {
+		unsigned int i;
+
+		prev = r;
+		r = t->wcet;
+		for (i = 0; i < rm_nr_tasks; i++) {
+			struct rm_task *hp = rm_tasks + i;
+
+			if (hp == t || hp->period > t->period) continue;
+			r += (prev + hp->period - 1) / hp->period * hp->wcet;
+		}
+	}
+	return r <= t->deadline ? r : 0;
+}
+
+static void __rm_report(void)
+{
+	double utilization = 0, bound;
+	bool schedulable = true;
+	unsigned int i;
+
+	printf("***** RM *****\n");
+	if (!rm_nr_tasks) {
+		printf("no periodic tasks\n\n");
+		return;
+	}
+
+	for (i = 0; i < rm_nr_tasks; i++) {
+		utilization += (double)rm_tasks[i].wcet / rm_tasks[i].period;
+	}
+	bound = rm_nr_tasks * (pow(2.0, 1.0 / rm_nr_tasks) - 1);
+
+	printf("tasks %u, utilization %.4f, Liu-Layland bound %.4f (%s)\n",
+			rm_nr_tasks, utilization, bound,
+			utilization <= bound ? "schedulable" : "inconclusive");
+	printf("%6s %8s %8s %8s %8s\n", "pid", "period", "wcet", "deadline", "response");
+	for (i = 0; i < rm_nr_tasks; i++) {
+		struct rm_task *t = rm_tasks + i;
+		unsigned long long r = __rm_response_time(t);
+
+		printf("%6u %8u %8u %8u ", t->pid, t->period, t->wcet, t->deadline);
+		if (r) {
+			printf("%8llu\n", r);
+		} else {
+			printf("%8s\n", "miss");
+			schedulable = false;
+		}
+	}
+	printf("response-time analysis: %s\n\n",
+			schedulable ? "schedulable" : "unschedulable");
+}
+
+static void rm_finalize(void)
+{
+	heap_destroy(&rm_rq);
+
+	if (metrics) __rm_report();
+
+	free(rm_tasks);
+	rm_tasks = NULL;
+	rm_nr_tasks = rm_max_tasks = 0;
+}
+
+static struct process *rm_schedule(void)
+{
+	return __heap_schedule(&rm_rq, __rm_key);
+}
+
+struct scheduler rm_scheduler = {
+	.name = "Rate Monotonic",
+	.acquire = fcfs_acquire,
+	.release = fcfs_release,
+	.finalize = rm_finalize,
+	.forked = rm_forked,
+	.schedule = rm_schedule,
+};
+
+
+
+
+/***********************************************************************
+ * Lottery scheduler
+ *
+ * Every lottery.quantum ticks, a ticket is drawn at random among those of
+ * the ready processes and the current one, and its holder runs next. The
+ * tickets are kept in a Fenwick tree over slots, one per process, so that
+ * both updating the tickets and finding the holder of the n-th ticket are
+ * O(log N). The draws come from the PRNG of prng.h seeded with
+ * lottery.seed, so runs are reproducible.
+ ***********************************************************************/
+static unsigned int lottery_quantum = 1;
+static unsigned int lottery_seed = 1;
+
+static unsigned long long *lottery_tree = NULL;	/* 1-based Fenwick tree */
+static struct process **lottery_procs = NULL;	/* Process in each slot */
+static unsigned int lottery_size = 0;			/* Power of two */
+static unsigned int lottery_nr_slots = 0;		/* Slots ever used */
+static unsigned int *lottery_free = NULL;		/* Stack of free slots */
+static unsigned int lottery_nr_free = 0;
+static unsigned long long lottery_total = 0;
+static struct prng lottery_prng;
+
+static void __lottery_update(unsigned int slot, unsigned long long delta)
+{
+	for (; slot <= lottery_size; slot += slot & -slot) {
+		lottery_tree[slot] += delta;
+	}
+}
+
+/* Slot holding the @n-th ticket, counting from 0 */
+static unsigned int __lottery_find(unsigned long long n)
+{
+	unsigned int slot = 0;
+
+	for (unsigned int step = lottery_size; step; step >>= 1) {
+		if (slot + step <= lottery_size && lottery_tree[slot + step] <= n) {
+			slot += step;
+			n -= lottery_tree[slot];
+		}
+	}
+	return slot + 1;
+}
+
+static void __lottery_grow(void)
+{
+	unsigned int size = lottery_size ? lottery_size * 2 : 64;
+
+	lottery_tree = realloc(lottery_tree, sizeof(*lottery_tree) * (size + 1));
+	lottery_procs = realloc(lottery_procs, sizeof(*lottery_procs) * (size + 1));
+	lottery_free = realloc(lottery_free, sizeof(*lottery_free) * (size + 1));
+	assert(lottery_tree && lottery_procs && lottery_free);
+
+	/* The new nodes cover the empty slots but the last, which covers all */
+	memset(lottery_tree + lottery_size + 1, 0x00,
+			sizeof(*lottery_tree) * (size - lottery_size));
+	lottery_tree[size] = lottery_total;
+	lottery_size = size;
+}
+
+static void __lottery_join(struct process *p)
+{
+	unsigned int slot;
+
+	if (lottery_nr_free) {
+		slot = lottery_free[--lottery_nr_free];
+	} else {
+		if (lottery_nr_slots == lottery_size) __lottery_grow();
+		slot = ++lottery_nr_slots;
+	}
+
+	lottery_procs[slot] = p;
+	p->share.slot = slot;
+	__lottery_update(slot, p->tickets);
+	lottery_total += p->tickets;
+}
+
+static void __lottery_leave(struct process *p)
+{
+	__lottery_update(p->share.slot, -(unsigned long long)p->tickets);
+	lottery_total -= p->tickets;
+	lottery_free[lottery_nr_free++] = p->share.slot;
+	p->share.slot = 0;
+}
+
+static int lottery_initialize(void)
+{
+	prng_seed(&lottery_prng, lottery_seed);
+	return 0;
+}
+
+static void lottery_finalize(void)
+{
+	free(lottery_tree);
+	free(lottery_procs);
+	free(lottery_free);
+	lottery_tree = NULL;
+	lottery_procs = NULL;
+	lottery_free = NULL;
+	lottery_size = lottery_nr_slots = lottery_nr_free = 0;
+}
+
+static struct process *lottery_schedule(void)
+{
+	struct process *p, *tmp;
+	bool runnable = current && current->status != PROCESS_WAIT &&
+			current->age < current->lifespan;
+
+	list_for_each_entry_safe(p, tmp, &readyqueue, list) {
+		ready_dequeue(p);
+		__lottery_join(p);
+	}
+
+	if (current) {
+		if (runnable) {
+			if (++current->share.used < lottery_quantum) return current;
+		} else {
+			__lottery_leave(current);
+		}
+	}
+
+	if (!lottery_total) return NULL;
+
+	p = lottery_procs[__lottery_find(prng_below(&lottery_prng, lottery_total))];
+	p->share.used = 0;
+	return p;
+}
+
+struct scheduler lottery_scheduler = {
+	.name = "Lottery",
+	.acquire = fcfs_acquire,
+	.release = fcfs_release,
+	.initialize = lottery_initialize,
+	.finalize = lottery_finalize,
+	.schedule = lottery_schedule,
+};
+
+
+
+/***********************************************************************
+ * Stride scheduler
+ *
+ * The deterministic counterpart of the lottery. Each process advances its
+ * pass by a stride of STRIDE1 / tickets for every tick it runs, and the
+ * one with the minimum pass runs every stride.quantum ticks. Processes
+ * joining the runqueue start from the pass of the last dispatched one so
+ * that they do not monopolize the processor to catch up.
+ ***********************************************************************/
+#define STRIDE1		(1ULL << 20)
+
+static unsigned int stride_quantum = 1;
+
+static struct heap stride_rq = HEAP_INIT;
+static unsigned long long stride_pass = 0;
+
+static void __stride_join(struct process *p)
+{
+	if (p->share.pass < stride_pass) p->share.pass = stride_pass;
+	heap_push(&stride_rq, p->share.pass, p);
+}
+
+static void stride_finalize(void)
+{
+	heap_destroy(&stride_rq);
+}
+
+static struct process *stride_schedule(void)
+{
+	struct process *p, *tmp;
+	bool runnable = current && current->status != PROCESS_WAIT &&
+			current->age < current->lifespan;
+
+	list_for_each_entry_safe(p, tmp, &readyqueue, list) {
+		ready_dequeue(p);
+		__stride_join(p);
+	}
+
+	if (current) {
+		/* Ticks blocked on resources do not advance the pass */
+		current->share.pass += STRIDE1 / current->tickets *
+				(current->age - current->share.last_age);
+		current->share.last_age = current->age;
+		if (runnable) {
+			if (++current->share.used < stride_quantum) return current;
+			heap_push(&stride_rq, current->share.pass, current);
+		}
+	}
+
+	if (heap_empty(&stride_rq)) return NULL;
+
+	p = heap_pop(&stride_rq);
+	stride_pass = p->share.pass;
+	p->share.used = 0;
+	p->share.last_age = p->age;
+	return p;
+}
+
+struct scheduler stride_scheduler = {
+	.name = "Stride",
+	.acquire = fcfs_acquire,
+	.release = fcfs_release,
+	.finalize = stride_finalize,
+	.schedule = stride_schedule,
+};
+
+
+
+
+/***********************************************************************
+ * O(1) scheduler
+ *
+ * The scheduler of Linux 2.6. There are 140 levels, where the lower level
+ * runs first; 0-99 are for real-time tasks, which are not modeled here,
+ * and priorities are mapped onto 100-139 like nice values. Each level has
+ * a FIFO queue in two arrays, active and expired, with a bitmap of the
+ * non-empty queues. The next process comes from the first set bit of the
+ * active array. When the active array empties, the two are swapped.
+ *
+ * A process gets a timeslice by its static level, o1.timeslice ticks at
+ * the level of nice 0, and goes to the expired array when it runs out,
+ * unless it is interactive and the expired ones are not starving. Sleeping
+ * in waitqueues earns sleep_avg and running spends it. The level is
+ * shifted by up to +-5 in proportion to sleep_avg, so I/O-bound processes
+ * get ahead of CPU hogs of the same static priority.
+ ***********************************************************************/
+#define O1_NR_LEVELS		140
+#define O1_MAX_RT_LEVEL		100
+#define O1_BITMAP_WORDS		((O1_NR_LEVELS + 31) / 32)
+#define O1_MAX_BONUS		10
+#define O1_INTERACTIVE_DELTA	2
+
+static unsigned int o1_timeslice = 10;
+
+struct o1_array {
+	unsigned int nr_active;
+	unsigned int bitmap[O1_BITMAP_WORDS];
+	struct list_head queues[O1_NR_LEVELS];
+};
+
+static struct {
+	struct o1_array arrays[2];
+	struct o1_array *active;
+	struct o1_array *expired;
+	unsigned int expired_since;	/* Tick the first process expired */
+
+	unsigned long long nr_swaps;
+	unsigned long long nr_expired;
+	unsigned long long nr_interactive;
+								/* Requeued to the active for interactivity */
+} o1;
+
+/* The longer the static level, the shorter the timeslice, 4x above nice 0 */
+static inline unsigned int __o1_timeslice(unsigned int static_prio)
+{
+	unsigned int slice = o1_timeslice * (O1_NR_LEVELS - static_prio) / 20;
+
+	if (static_prio < 120) slice *= 4;
+	return slice ? slice : 1;
+}
+
+static inline unsigned int __o1_max_sleep_avg(void)
+{
+	return o1_timeslice * 10;
+}
+
+static inline int __o1_bonus(struct process *p)
+{
+	return (int)(p->o1.sleep_avg * O1_MAX_BONUS / __o1_max_sleep_avg()) -
+			O1_MAX_BONUS / 2;
+}
+
+static void __o1_effective_prio(struct process *p)
+{
+	int prio = (int)p->o1.static_prio - __o1_bonus(p);
+
+	if (prio < O1_MAX_RT_LEVEL) prio = O1_MAX_RT_LEVEL;
+	if (prio > O1_NR_LEVELS - 1) prio = O1_NR_LEVELS - 1;
+	p->o1.prio = prio;
+}
+
+/* Whether the bonus of @p outweighs its niceness. Cf. TASK_INTERACTIVE() */
+static inline bool __o1_interactive(struct process *p)
+{
+	int nice = (int)p->o1.static_prio - 120;
+	int delta = nice * O1_MAX_BONUS / 40 + O1_INTERACTIVE_DELTA;
+
+	return (int)p->o1.prio <= (int)p->o1.static_prio - delta;
+}
+
+static inline bool __o1_expired_starving(void)
+{
+	return o1.expired->nr_active &&
+			ticks - o1.expired_since >= __o1_max_sleep_avg();
+}
+
+static void __o1_enqueue(struct o1_array *array, struct process *p, bool head)
+{
+	unsigned int level = p->o1.prio;
+
+	if (head) {
+		list_add(&p->list, array->queues + level);
+	} else {
+		list_add_tail(&p->list, array->queues + level);
+	}
+	array->bitmap[level / 32] |= 1U << (level % 32);
+	array->nr_active++;
+}
+
+static struct process *__o1_dequeue_first(struct o1_array *array)
+{
+	struct process *p;
+	unsigned int level;
+	int i;
+
+	for (i = 0; !array->bitmap[i]; i++);
+	level = i * 32 + __builtin_ctz(array->bitmap[i]);
+
+	p = list_first_entry(array->queues + level, struct process, list);
+	list_del_init(&p->list);
+	if (list_empty(array->queues + level)) {
+		array->bitmap[level / 32] &= ~(1U << (level % 32));
+	}
+	array->nr_active--;
+	return p;
+}
+
+/* The first level of @array, or O1_NR_LEVELS if empty */
+static unsigned int __o1_first_level(struct o1_array *array)
+{
+	for (int i = 0; i < O1_BITMAP_WORDS; i++) {
+		if (array->bitmap[i]) return i * 32 + __builtin_ctz(array->bitmap[i]);
+	}
+	return O1_NR_LEVELS;
+}
+
+static int o1_initialize(void)
+{
+	if (!o1_timeslice) {
+		fprintf(stderr, "o1.timeslice should be positive\n");
+		return -1;
+	}
+
+	for (int i = 0; i < 2; i++) {
+		memset(o1.arrays[i].bitmap, 0x00, sizeof(o1.arrays[i].bitmap));
+		o1.arrays[i].nr_active = 0;
+		for (int level = 0; level < O1_NR_LEVELS; level++) {
+			INIT_LIST_HEAD(o1.arrays[i].queues + level);
+		}
+	}
+	o1.active = o1.arrays;
+	o1.expired = o1.arrays + 1;
+	return 0;
+}
+
+static void o1_finalize(void)
+{
+	if (!metrics) return;
+
+	printf("***** O(1) *****\n");
+	printf("array swaps %llu, expired %llu, interactive requeues %llu\n\n",
+			o1.nr_swaps, o1.nr_expired, o1.nr_interactive);
+}
+
+static void o1_forked(struct process *p)
+{
+	p->o1.static_prio = O1_NR_LEVELS - 1 - p->prio * 40 / (MAX_PRIO + 1);
+	if (p->o1.static_prio < O1_MAX_RT_LEVEL) p->o1.static_prio = O1_MAX_RT_LEVEL;
+	p->o1.time_slice = __o1_timeslice(p->o1.static_prio);
+	p->o1.sleep_avg = 0;
+	p->o1.sleeping = false;
+	__o1_effective_prio(p);
+}
+
+static struct process *o1_schedule(void)
+{
+	struct process *p, *tmp;
+	bool runnable = current && current->status != PROCESS_WAIT &&
+			current->age < current->lifespan;
+
+	/* Newcomers and wakers go to the active array, crediting the sleep */
+	list_for_each_entry_safe(p, tmp, &readyqueue, list) {
+		ready_dequeue(p);
+		if (p->o1.sleeping) {
+			p->o1.sleep_avg += ticks - p->o1.sleep_start;
+			if (p->o1.sleep_avg > __o1_max_sleep_avg()) {
+				p->o1.sleep_avg = __o1_max_sleep_avg();
+			}
+			p->o1.sleeping = false;
+			__o1_effective_prio(p);
+		}
+		__o1_enqueue(o1.active, p, false);
+	}
+
+	if (current && current->status == PROCESS_WAIT) {
+		current->o1.sleeping = true;
+		current->o1.sleep_start = ticks;
+	}
+
+	if (runnable) {
+		if (current->o1.sleep_avg) current->o1.sleep_avg--;
+
+		if (--current->o1.time_slice == 0) {
+			__o1_effective_prio(current);
+			current->o1.time_slice = __o1_timeslice(current->o1.static_prio);
+
+			if (__o1_interactive(current) && !__o1_expired_starving()) {
+				__o1_enqueue(o1.active, current, false);
+				o1.nr_interactive++;
+			} else {
+				if (!o1.expired->nr_active) o1.expired_since = ticks;
+				__o1_enqueue(o1.expired, current, false);
+				o1.nr_expired++;
+			}
+		} else if (__o1_first_level(o1.active) < current->o1.prio) {
+			/* Preempted, but keeps its place at the head of the level */
+			__o1_enqueue(o1.active, current, true);
+		} else {
+			return current;
+		}
+	}
+
+	if (!o1.active->nr_active) {
+		struct o1_array *array = o1.active;
+
+		o1.active = o1.expired;
+		o1.expired = array;
+		if (o1.active->nr_active) o1.nr_swaps++;
+	}
+	if (!o1.active->nr_active) return NULL;
+
+	return __o1_dequeue_first(o1.active);
+}
+
+struct scheduler o1_scheduler = {
+	.name = "O(1)",
+	.acquire = fcfs_acquire,
+	.release = fcfs_release,
+	.initialize = o1_initialize,
+	.finalize = o1_finalize,
+	.forked = o1_forked,
+	.schedule = o1_schedule,
+};
+
+
+
+
+/***********************************************************************
+ * Predictive SJF and SRTF schedulers
+ *
+ * SJF and SRTF above peek at the lifespan, which no real system knows.
+ * These predict the length of the next CPU burst from the past ones by
+ * exponential averaging instead:
+ *
+ *   predicted' = alpha * observed + (1 - alpha) * predicted
+ *
+ * where alpha is psjf.alpha percent. A burst is the ticks a process runs
+ * from getting ready until it blocks on a resource or exits. A process
+ * starts with the average over all bursts observed so far, or with
+ * psjf.initial ticks until there is any.
+ *
+ * Predictive SJF runs the process with the shortest predicted burst to the
+ * end of the burst. Predictive SRTF preempts the current process when a
+ * ready one is predicted to finish its burst earlier than it. Run the
+ * oracle ones on the same workload with -m to see the gap in waiting time.
+ ***********************************************************************/
+static unsigned int psjf_alpha = 50;
+static unsigned int psjf_initial = 5;
+
+static struct heap psjf_rq = HEAP_INIT;
+static unsigned int psjf_average;		/* Over all bursts so far */
+static bool psjf_observed;
+
+static struct {
+	unsigned long long nr;
+	double abs_sum;
+	double sum;					/* Signed; positive if overestimated */
+	struct hist abs;			/* |error| in ticks */
+} psjf_error;
+
+static inline unsigned int __psjf_average(unsigned int predicted,
+		unsigned int observed)
+{
+	return ((unsigned long long)psjf_alpha * observed * BURST_SCALE +
+			(unsigned long long)(100 - psjf_alpha) * predicted) / 100;
+}
+
+/* Predicted ticks left in the current burst of @p */
+static inline unsigned long long __psjf_remaining(struct process *p)
+{
+	unsigned long long ran = (unsigned long long)p->burst.ran * BURST_SCALE;
+
+	return p->burst.predicted > ran ? p->burst.predicted - ran : 0;
+}
+
+static void __psjf_end_burst(struct process *p)
+{
+	double error = (double)p->burst.predicted / BURST_SCALE - p->burst.ran;
+	double abs = error >= 0 ? error : -error;
+
+	psjf_error.nr++;
+	psjf_error.sum += error;
+	psjf_error.abs_sum += abs;
+	hist_record(&psjf_error.abs, (unsigned int)(abs + 0.5));
+
+	p->burst.predicted = __psjf_average(p->burst.predicted, p->burst.ran);
+	psjf_average = psjf_observed ?
+			__psjf_average(psjf_average, p->burst.ran) : p->burst.ran * BURST_SCALE;
+	psjf_observed = true;
+	p->burst.ran = 0;
+}
+
+static int psjf_initialize(void)
+{
+	if (psjf_alpha > 100) {
+		fprintf(stderr, "psjf.alpha should be in [0, 100]\n");
+		return -1;
+	}
+	psjf_average = psjf_initial * BURST_SCALE;
+	return 0;
+}
+
+static void psjf_finalize(void)
+{
+	heap_destroy(&psjf_rq);
+
+	if (!metrics) return;
+
+	printf("***** BURST PREDICTION *****\n");
+	printf("bursts %llu, alpha %u%%\n", psjf_error.nr, psjf_alpha);
+	if (psjf_error.nr) {
+		printf("error mean %.2f, bias %+.2f, p50 %u, p90 %u, p99 %u, max %u\n",
+				psjf_error.abs_sum / psjf_error.nr, psjf_error.sum / psjf_error.nr,
+				hist_percentile(&psjf_error.abs, 50),
+				hist_percentile(&psjf_error.abs, 90),
+				hist_percentile(&psjf_error.abs, 99), psjf_error.abs.max);
+	}
+	printf("\n");
+}
+
+static void psjf_forked(struct process *p)
+{
+	p->burst.predicted = psjf_average;
+	p->burst.ran = 0;
+}
+
+/**
+ * Move the newly ready processes into the runqueue keyed by their
+ * predicted remaining bursts, and account the last tick to the current.
+ * Returns true if the current is to continue its burst
+ */
+static bool __psjf_update(void)
+{
+	struct process *p, *tmp;
+
+	list_for_each_entry_safe(p, tmp, &readyqueue, list) {
+		ready_dequeue(p);
+		heap_push(&psjf_rq, __psjf_remaining(p), p);
+	}
+
+	if (!current) return false;
+
+	if (current->status != PROCESS_WAIT) current->burst.ran++;
+
+	if (current->status == PROCESS_WAIT || current->age == current->lifespan) {
+		__psjf_end_burst(current);
+		return false;
+	}
+	return true;
+}
+
+static struct process *psjf_schedule(void)
+{
+	if (__psjf_update()) return current;
+
+	return heap_pop(&psjf_rq);
+}
+
+static struct process *psrtf_schedule(void)
+{
+	if (__psjf_update()) {
+		unsigned long long remaining = __psjf_remaining(current);
+
+		if (heap_empty(&psjf_rq) || heap_peek_key(&psjf_rq) >= remaining) {
+			return current;
+		}
+		heap_push(&psjf_rq, remaining, current);
+	}
+
+	return heap_pop(&psjf_rq);
+}
+
+struct scheduler psjf_scheduler = {
+	.name = "Predictive Shortest-Job First",
+	.acquire = fcfs_acquire,
+	.release = fcfs_release,
+	.initialize = psjf_initialize,
+	.finalize = psjf_finalize,
+	.forked = psjf_forked,
+	.schedule = psjf_schedule,
+};
+
+struct scheduler psrtf_scheduler = {
+	.name = "Predictive Shortest Remaining Time First",
+	.acquire = fcfs_acquire,
+	.release = fcfs_release,
+	.initialize = psjf_initialize,
+	.finalize = psjf_finalize,
+	.forked = psjf_forked,
+	.schedule = psrtf_schedule,
+};
+
+
+
+
+/***********************************************************************
+ * Highest response ratio next scheduler
+ *
+ * When the processor becomes free, the ready process with the highest
+ * response ratio (wait + service) / service runs to the end of its burst,
+ * where the service is the remaining lifespan. Short processes get ahead
+ * like SJF, but the ratio of a long one grows as it waits, so it cannot
+ * starve.
+ *
+ * The ratio of a process is 1 + (t - arrival) / service, a line in the
+ * tick t, and all of them change every tick. The processes are kept in a
+ * kinetic tournament tree: each internal node holds the winner of its
+ * two children at the current tick along with the tick its certificate
+ * fails, i.e., the loser overtakes the winner. Ticks move forward by
+ * replaying only the nodes whose certificates have failed, with the
+ * earliest failure in each subtree guiding the way, so neither a pick nor
+ * a tick rescans the ready processes.
+ ***********************************************************************/
+#define HRRN_NEVER	(~0ULL)
+
+static struct hrrn_node {
+	struct process *winner;
+	unsigned long long fails;	/* Tick the loser overtakes @winner */
+	unsigned long long next;	/* Earliest @fails in the subtree */
+} *hrrn_tree = NULL;			/* 1-based; the leaves from @hrrn_size */
+static unsigned int hrrn_size = 0;
+static unsigned int hrrn_nr_slots = 0;
+static unsigned int *hrrn_free = NULL;
+static unsigned int hrrn_nr_free = 0;
+static unsigned long long hrrn_nr_events = 0;
+
+static inline unsigned int __hrrn_service(struct process *p)
+{
+	return p->lifespan - p->age;
+}
+
+/* Whether @a has a higher response ratio than @b at tick @t. Ties are
+ * broken by the ratio right after @t, then by the arrival */
+static bool __hrrn_beats(struct process *a, struct process *b, unsigned long long t)
+{
+	unsigned long long sa = __hrrn_service(a), sb = __hrrn_service(b);
+	unsigned long long ra = (t - a->hrrn.arrival) * sb;
+	unsigned long long rb = (t - b->hrrn.arrival) * sa;
+
+	if (ra != rb) return ra > rb;
+	if (sa != sb) return sa < sb;
+	if (a->hrrn.arrival != b->hrrn.arrival) return a->hrrn.arrival < b->hrrn.arrival;
+	return a->hrrn.slot < b->hrrn.slot;
+}
+
+/* First tick after @now when @loser overtakes @winner */
+static unsigned long long __hrrn_fails(struct process *winner,
+		struct process *loser, unsigned long long now)
+{
+	double sw = __hrrn_service(winner), sl = __hrrn_service(loser);
+	double cross;
+	unsigned long long t;
+
+	/* Only a steeper line can catch up */
+	if (sl >= sw) return HRRN_NEVER;
+
+	cross = ((double)loser->hrrn.arrival * sw - (double)winner->hrrn.arrival * sl) /
+			(sw - sl);
+	t = cross > now ? (unsigned long long)ceil(cross) : now + 1;
+
+	/* Fix up the rounding */
+	while (t > now + 1 && __hrrn_beats(loser, winner, t - 1)) t--;
+	while (!__hrrn_beats(loser, winner, t)) t++;
+	return t;
+}
+
+static void __hrrn_pull(unsigned int node, unsigned long long now)
+{
+	struct hrrn_node *n = hrrn_tree + node;
+	struct hrrn_node *l = hrrn_tree + node * 2, *r = hrrn_tree + node * 2 + 1;
+
+	n->fails = HRRN_NEVER;
+	if (!l->winner || !r->winner) {
+		n->winner = l->winner ? l->winner : r->winner;
+	} else if (__hrrn_beats(l->winner, r->winner, now)) {
+		n->winner = l->winner;
+		n->fails = __hrrn_fails(l->winner, r->winner, now);
+	} else {
+		n->winner = r->winner;
+		n->fails = __hrrn_fails(r->winner, l->winner, now);
+	}
+
+	n->next = n->fails;
+	if (l->next < n->next) n->next = l->next;
+	if (r->next < n->next) n->next = r->next;
+}
+
+/* Replay the failed certificates under @node up to tick @now */
+static void __hrrn_advance(unsigned int node, unsigned long long now)
+{
+	if (hrrn_tree[node].next > now) return;
+
+	__hrrn_advance(node * 2, now);
+	__hrrn_advance(node * 2 + 1, now);
+	__hrrn_pull(node, now);
+	hrrn_nr_events++;
+}
+
+static void __hrrn_set(unsigned int slot, struct process *p)
+{
+	unsigned int node = hrrn_size + slot;
+
+	hrrn_tree[node].winner = p;
+	for (node /= 2; node; node /= 2) {
+		__hrrn_pull(node, ticks);
+	}
+}
+
+static void __hrrn_grow(void)
+{
+	unsigned int size = hrrn_size ? hrrn_size * 2 : 64;
+	struct hrrn_node *tree = calloc(size * 2, sizeof(*tree));
+
+	assert(tree);
+	for (unsigned int i = 0; i < size; i++) {
+		tree[size + i].next = tree[size + i].fails = HRRN_NEVER;
+		if (i < hrrn_size) tree[size + i].winner = hrrn_tree[hrrn_size + i].winner;
+	}
+	free(hrrn_tree);
+	hrrn_tree = tree;
+	hrrn_size = size;
+
+	for (unsigned int node = size - 1; node; node--) {
+		__hrrn_pull(node, ticks);
+	}
+
+	hrrn_free = realloc(hrrn_free, sizeof(*hrrn_free) * size);
+	assert(hrrn_free);
+}
+
+static void __hrrn_enqueue(struct process *p)
+{
+	unsigned int slot;
+
+	if (hrrn_nr_free) {
+		slot = hrrn_free[--hrrn_nr_free];
+	} else {
+		if (hrrn_nr_slots == hrrn_size) __hrrn_grow();
+		slot = hrrn_nr_slots++;
+	}
+
+	p->hrrn.slot = slot;
+	p->hrrn.arrival = ticks - p->hrrn.waited;
+	__hrrn_set(slot, p);
+}
+
+static struct process *__hrrn_dequeue_first(void)
+{
+	struct process *p = hrrn_size ? hrrn_tree[1].winner : NULL;
+
+	if (!p) return NULL;
+
+	__hrrn_set(p->hrrn.slot, NULL);
+	hrrn_free[hrrn_nr_free++] = p->hrrn.slot;
+	p->hrrn.waited = ticks - p->hrrn.arrival;
+	return p;
+}
+
+static void hrrn_finalize(void)
+{
+	free(hrrn_tree);
+	free(hrrn_free);
+	hrrn_tree = NULL;
+	hrrn_free = NULL;
+	hrrn_size = hrrn_nr_slots = hrrn_nr_free = 0;
+
+	if (!metrics) return;
+
+	printf("***** HRRN *****\n");
+	printf("tournament nodes replayed %llu\n\n", hrrn_nr_events);
+}
+
+static void hrrn_forked(struct process *p)
+{
+	p->hrrn.waited = 0;
+}
+
+static struct process *hrrn_schedule(void)
+{
+	struct process *p, *tmp;
+
+	if (hrrn_size) __hrrn_advance(1, ticks);
+
+	list_for_each_entry_safe(p, tmp, &readyqueue, list) {
+		ready_dequeue(p);
+		__hrrn_enqueue(p);
+	}
+
+	if (current && current->status != PROCESS_WAIT &&
+			current->age < current->lifespan) {
+		return current;
+	}
+
+	return __hrrn_dequeue_first();
+}
+
+struct scheduler hrrn_scheduler = {
+	.name = "Highest Response Ratio Next",
+	.acquire = fcfs_acquire,
+	.release = fcfs_release,
+	.finalize = hrrn_finalize,
+	.forked = hrrn_forked,
+	.schedule = hrrn_schedule,
+};
+
+
+
+/***********************************************************************
+ * Tunables of the schedulers, which are set with -k name=value
+ ***********************************************************************/
+static struct tunable {
+	const char *name;
+	unsigned int *value;
+} __tunables[] = {
+	{ "cfs.latency", &cfs_latency },
+	{ "cfs.min_granularity", &cfs_min_granularity },
+	{ "cfs.wakeup_granularity", &cfs_wakeup_granularity },
+	{ "eevdf.base_slice", &eevdf_base_slice },
+	{ "mlfq.levels", &mlfq_levels },
+	{ "mlfq.quantum", &mlfq_quantum },
+	{ "mlfq.boost", &mlfq_boost },
+	{ "edf.admission", &edf_admission },
+	{ "lottery.quantum", &lottery_quantum },
+	{ "lottery.seed", &lottery_seed },
+	{ "stride.quantum", &stride_quantum },
+	{ "o1.timeslice", &o1_timeslice },
+	{ "psjf.alpha", &psjf_alpha },
+	{ "psjf.initial", &psjf_initial },
+};
+
+bool set_tunable(char * const name, char * const value)
+{
+	for (int i = 0; i < sizeof(__tunables) / sizeof(*__tunables); i++) {
+		char *end;
+		unsigned long v;
+
+		if (strcmp(name, __tunables[i].name)) continue;
+
+		v = strtoul(value, &end, 10);
+		if (*value == '\0' || *value == '-' || *end != '\0') {
+			fprintf(stderr, "Invalid value %s for %s\n", value, name);
+			return false;
+		}
+		*__tunables[i].value = v;
+		return true;
+	}
+
+	fprintf(stderr, "Unknown tunable %s. Available ones are:\n", name);
+	for (int i = 0; i < sizeof(__tunables) / sizeof(*__tunables); i++) {
+		fprintf(stderr, "  %s (%u)\n", __tunables[i].name, *__tunables[i].value);
+	}
+	return false;
+}
@@ -0,0 +1,121 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "pool.h"
+
+void pool_init(struct pool *pool, const char *name, size_t size)
+{
+	/* Objects should be large enough to link the free list */
+	if (size < sizeof(void *)) size = sizeof(void *);
+
+	pool->name = name;
+	pool->size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+	pool->chunks = NULL;
+	pool->nr_chunks = pool->max_chunks = 0;
+	pool->nr_carved = 0;
+	pool->free = NULL;
+	pool->free_index = POOL_NO_INDEX;
+	pool->nr_in_use = pool->peak_in_use = 0;
+}
+
+void pool_destroy(struct pool *pool)
+{
+	for (int i = 0; i < pool->nr_chunks; i++) {
+		free(pool->chunks[i]);
+	}
+	free(pool->chunks);
+	pool_init(pool, pool->name, pool->size);
+}
+
+static void __pool_grow(struct pool *pool)
+{
+	if (pool->nr_chunks == pool->max_chunks) {
+		pool->max_chunks = pool->max_chunks ? pool->max_chunks * 2 : 4;
+		pool->chunks = realloc(pool->chunks,
+				pool->max_chunks * sizeof(*pool->chunks));
+		assert(pool->chunks);
+	}
+
+	pool->chunks[pool->nr_chunks] = malloc(POOL_CHUNK_OBJS * pool->size);
+	assert(pool->chunks[pool->nr_chunks]);
+	pool->nr_chunks++;
+}
+
+static unsigned int __pool_carve(struct pool *pool)
+{
+	if (pool->nr_carved == pool->nr_chunks * POOL_CHUNK_OBJS) {
+		__pool_grow(pool);
+	}
+	return pool->nr_carved++;
+}
+
+static inline void __pool_account_alloc(struct pool *pool)
+{
+	if (++pool->nr_in_use > pool->peak_in_use) {
+		pool->peak_in_use = pool->nr_in_use;
+	}
+}
+
+void *pool_alloc(struct pool *pool)
+{
+	void *obj;
+
+	if (pool->free) {
+		obj = pool->free;
+		pool->free = *(void **)obj;
+	} else {
+		obj = pool_at(pool, __pool_carve(pool));
+	}
+
+	__pool_account_alloc(pool);
+	return obj;
+}
+
+void pool_free(struct pool *pool, void *obj)
+{
+	assert(pool->nr_in_use > 0);
+
+	*(void **)obj = pool->free;
+	pool->free = obj;
+	pool->nr_in_use--;
+}
+
+unsigned int pool_alloc_index(struct pool *pool)
+{
+	unsigned int index;
+
+	if (pool->free_index != POOL_NO_INDEX) {
+		index = pool->free_index;
+		pool->free_index = *(unsigned int *)pool_at(pool, index);
+	} else {
+		index = __pool_carve(pool);
+	}
+
+	__pool_account_alloc(pool);
+	return index;
+}
+
+void pool_free_index(struct pool *pool, unsigned int index)
+{
+	assert(pool->nr_in_use > 0 && index < pool->nr_carved);
+
+	*(unsigned int *)pool_at(pool, index) = pool->free_index;
+	pool->free_index = index;
+	pool->nr_in_use--;
+}
@@ -0,0 +1,91 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stddef.h>
+
+/**
+ * Number of objects carved out of a single chunk. Chunks are allocated
+ * in bulk and never returned to the system until the pool is destroyed.
+ */
+#define POOL_CHUNK_SHIFT	12
+#define POOL_CHUNK_OBJS		(1U << POOL_CHUNK_SHIFT)
+
+/***********************************************************************
+ * struct pool
+ *
+ * DESCRIPTION
+ *   Slab of fixed-size objects. Objects are handed out from bulk-allocated
+ *   chunks and freed objects are recycled through a free list, so that
+ *   a long simulation does not hit malloc() for every process and
+ *   resource schedule.
+ */
+struct pool {
+	const char *name;
+	size_t size;				/* Size of an object, aligned */
+
+	char **chunks;				/* Table of chunks */
+	unsigned int nr_chunks;
+	unsigned int max_chunks;
+
+	unsigned int nr_carved;		/* # of objects carved out of chunks so far */
+	void *free;					/* Free list of recycled objects */
+	unsigned int free_index;	/* Ditto, for the objects freed by index */
+
+	size_t nr_in_use;			/* # of objects currently allocated */
+	size_t peak_in_use;			/* High watermark of @nr_in_use */
+};
+
+void pool_init(struct pool *pool, const char *name, size_t size);
+void pool_destroy(struct pool *pool);
+
+void *pool_alloc(struct pool *pool);
+void pool_free(struct pool *pool, void *obj);
+
+/**
+ * Objects can be addressed by a 32-bit index as well. An index-based user
+ * should allocate and free objects with pool_alloc_index() and
+ * pool_free_index() only; the two free lists are not shared.
+ */
+#define POOL_NO_INDEX	(~0U)
+
+unsigned int pool_alloc_index(struct pool *pool);
+void pool_free_index(struct pool *pool, unsigned int index);
+
+static inline void *pool_at(struct pool *pool, unsigned int index)
+{
+	return pool->chunks[index >> POOL_CHUNK_SHIFT] +
+			(index & (POOL_CHUNK_OBJS - 1)) * pool->size;
+}
+
+static inline size_t pool_bytes_in_use(struct pool *pool)
+{
+	return pool->nr_in_use * pool->size;
+}
+
+static inline size_t pool_bytes_peak(struct pool *pool)
+{
+	return pool->peak_in_use * pool->size;
+}
+
+static inline size_t pool_bytes_footprint(struct pool *pool)
+{
+	return (size_t)pool->nr_chunks * POOL_CHUNK_OBJS * pool->size +
+			pool->max_chunks * sizeof(*pool->chunks);
+}
+
+#endif
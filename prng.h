@@ -0,0 +1,71 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#ifndef __PRNG_H__
+#define __PRNG_H__
+
+/***********************************************************************
+ * Seeded pseudo-random number generator
+ *
+ * DESCRIPTION
+ *   xorshift64* seeded through splitmix64. Unlike rand(), the sequence
+ *   for a seed is the same on every platform, so workloads and runs can
+ *   be reproduced from the seed alone.
+ */
+struct prng {
+	unsigned long long state;
+};
+
+static inline void prng_seed(struct prng *r, unsigned long long seed)
+{
+	unsigned long long z = seed + 0x9e3779b97f4a7c15ULL;
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	r->state = (z ^ (z >> 31)) | 1;
+}
+
+static inline unsigned long long prng_next(struct prng *r)
+{
+	r->state ^= r->state >> 12;
+	r->state ^= r->state << 25;
+	r->state ^= r->state >> 27;
+	return r->state * 0x2545f4914f6cdd1dULL;
+}
+
+/* Uniform in [0, 1) */
+static inline double prng_double(struct prng *r)
+{
+	return (prng_next(r) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * Uniform in [0, @n). Draws below 2^64 mod @n are rejected so that every
+ * residue is equally likely
+ */
+static inline unsigned long long prng_below(struct prng *r, unsigned long long n)
+{
+	unsigned long long threshold, v;
+
+	if (!n) return 0;
+
+	threshold = -n % n;
+	do {
+		v = prng_next(r);
+	} while (v < threshold);
+	return v % n;
+}
+
+#endif
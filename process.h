@@ -16,6 +16,9 @@
 #ifndef __PROCESS_H__
 #define __PROCESS_H__
 
+#include "ilist.h"
+#include "rbtree.h"
+
 struct list_head;
 
 enum process_status {
@@ -25,6 +28,76 @@ enum process_status {
 	PROCESS_EXIT,		/* The process is exited */
 };
 
+/**
+ * Per-process state of the fair schedulers. See CFS in pa2.c
+ */
+struct sched_entity {
+	struct rb_node run_node;	/* Node in the runqueue tree */
+	unsigned int weight;		/* Load weight derived from the priority */
+	unsigned long long vruntime;
+								/* Virtual runtime, scaled by the weight */
+	unsigned int last_age;		/* Age accounted into @vruntime so far */
+	unsigned int slice_start;	/* Age when switched in last time */
+
+	unsigned long long deadline;
+								/* Virtual deadline of the current request */
+	long long vlag;				/* Lag kept while waiting for a resource */
+	unsigned long long min_vruntime;
+								/* Minimum @vruntime in the subtree */
+};
+
+/**
+ * Per-process state of the multi-level feedback queue scheduler
+ */
+struct mlfq_entity {
+	unsigned int level;			/* Level of the queue */
+	unsigned int used;			/* Ticks used at @level */
+	unsigned int epoch;			/* Boost epoch when @level was set */
+};
+
+/**
+ * Per-process state of the proportional-share schedulers
+ */
+struct share_entity {
+	unsigned int slot;			/* Slot in the lottery tree. 0 if not in it */
+	unsigned int used;			/* Ticks used in the current quantum */
+	unsigned long long pass;	/* Pass value of stride scheduling */
+	unsigned int last_age;		/* Age accounted into @pass so far */
+};
+
+/**
+ * Per-process state of the O(1) scheduler
+ */
+struct o1_entity {
+	unsigned int static_prio;	/* Level by the priority in [100, 140) */
+	unsigned int prio;			/* Level with the interactivity bonus */
+	unsigned int time_slice;	/* Ticks left in the current timeslice */
+	unsigned int sleep_avg;		/* Ticks credited for sleeping */
+	unsigned int sleep_start;	/* Tick started sleeping in a waitqueue */
+	bool sleeping;
+};
+
+/**
+ * Per-process state of the predictive SJF and SRTF schedulers
+ */
+struct burst_entity {
+	unsigned int predicted;		/* Predicted length of the next CPU burst
+								   in 1/BURST_SCALE ticks */
+	unsigned int ran;			/* Ticks run in the current burst */
+};
+
+#define BURST_SCALE	256
+
+/**
+ * Per-process state of the highest-response-ratio-next scheduler
+ */
+struct hrrn_entity {
+	unsigned int slot;			/* Leaf in the tournament tree */
+	unsigned int arrival;		/* Tick it would have arrived at to have
+								   waited as long as so far in one go */
+	unsigned int waited;		/* Ticks waited ready so far */
+};
+
 struct process {
 	unsigned int pid;		/* Process ID */
 
@@ -39,6 +112,12 @@ struct process {
 							   0 by default, and the larger, the more important
 							   process it is */
 
+	unsigned int __starts_at;
+							/* When to fork the process. DO NOT ACCESS.
+							   Kept in the cache line of @list, as the
+							   framework walks through the forkqueue
+							   every tick */
+
 	struct list_head list;	/* list head for listing processes */
 
 	/**
@@ -46,15 +125,58 @@ struct process {
 	 */
 	unsigned int prio_orig;	/* The original priority of the process */
 
+	unsigned int deadline;	/* Tick by which the process should complete.
+							   0 if the process has no deadline */
 
-	/** DO NOT ACCESS FOLLOWING VARIABLES **/
-	unsigned int __starts_at;	/* When to fork the process */
+	unsigned int period;	/* Ticks between the releases of jobs.
+							   0 for one-shot processes */
+	unsigned int wcet;		/* Worst-case execution time of each job */
+
+	unsigned int tickets;	/* Tickets for the proportional-share schedulers.
+							   prio + 1 by default */
+
+	unsigned int slice;		/* Slice requested to the fair schedulers in
+							   ticks. 0 for the default */
+
+	/**
+	 * State private to the scheduler in use. Only one scheduler runs at a
+	 * time, so they share the space. Zeroed when the process is loaded
+	 */
+	union {
+		struct sched_entity se;		/* For the fair schedulers */
+		struct mlfq_entity mlfq;	/* For MLFQ */
+		struct share_entity share;	/* For lottery and stride */
+		struct o1_entity o1;		/* For the O(1) scheduler */
+		struct burst_entity burst;	/* For the predictive SJF and SRTF */
+		struct hrrn_entity hrrn;	/* For HRRN */
+	};
 
-	struct list_head __resources_to_acquire;
+	/** DO NOT ACCESS FOLLOWING VARIABLES **/
+	struct ilist_head __resources_to_acquire;
 								/* Schedule to acquire resources */
 
-	struct list_head __resources_holding;
+	struct ilist_head __resources_holding;
 								/* Resources that the process is currently holding */
+
+	struct ilist_head __io_phases;
+								/* I/O to do after CPU phases */
+
+	unsigned int __ready_slot;	/* Slot in the ready table for the SoA engine */
+
+	/* Scheduling metrics. See metrics.h */
+	unsigned int __first_run;	/* Tick dispatched first */
+	unsigned int __wait_since;	/* Tick started waiting for a resource */
+	int __wait_resource;		/* Resource blocked on until acquiring it */
+	unsigned int __wait_ticks;	/* Ticks spent in resource waitqueues */
+	unsigned int __io_since;	/* Tick started sleeping for I/O */
+	unsigned int __io_ticks;	/* Ticks spent sleeping for I/O */
+	unsigned int __blocked_ticks;
+								/* Ticks blocked while acquiring resources */
+	unsigned int __switches;	/* # of times switched in */
+	unsigned int __switch_ticks;
+								/* Ticks spent switching into the process */
+	unsigned int __share_slot;	/* Index among the runnable processes.
+								   METRICS_NONE while not runnable */
 };
 
 /**
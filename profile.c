@@ -0,0 +1,110 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#include "profile.h"
+
+#ifdef CONFIG_PROFILE
+
+#include <stdio.h>
+#include <time.h>
+
+#include "hist.h"
+
+static const char * __profile_point_sz[] = {
+	"tick",
+	"fork",
+	"schedule",
+	"acquire",
+	"release",
+	"output",
+	"cb.schedule",
+	"cb.acquire",
+	"cb.release",
+	"cb.forked",
+	"cb.exiting",
+};
+
+static struct {
+	unsigned long long total;
+	struct hist hist;
+} __points[NR_PROFILE_POINTS];
+
+static unsigned long long __begin_cycles, __end_cycles;
+static unsigned long long __begin_ns, __end_ns;
+
+static unsigned long long __clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#if !defined(__x86_64__) && !defined(__i386__)
+unsigned long long profile_now(void)
+{
+	return __clock_ns();
+}
+#endif
+
+void profile_record(enum profile_point point, unsigned long long cycles)
+{
+	__points[point].total += cycles;
+	hist_record(&__points[point].hist,
+			cycles > 0xffffffffULL ? 0xffffffffU : (unsigned int)cycles);
+}
+
+void profile_begin(void)
+{
+	__begin_ns = __clock_ns();
+	__begin_cycles = profile_now();
+}
+
+void profile_end(void)
+{
+	__end_ns = __clock_ns();
+	__end_cycles = profile_now();
+}
+
+void profile_report(unsigned int nr_ticks)
+{
+	unsigned long long elapsed_ns = __end_ns - __begin_ns;
+	unsigned long long elapsed_cycles = __end_cycles - __begin_cycles;
+	double ns_per_cycle = elapsed_cycles ? (double)elapsed_ns / elapsed_cycles : 1.0;
+
+	fprintf(stderr, "***** PROFILE *****\n");
+	fprintf(stderr, "elapsed %.3f ms, %u ticks, %.0f ticks/sec, %.4f ns/cycle\n",
+			elapsed_ns / 1e6, nr_ticks,
+			elapsed_ns ? nr_ticks / (elapsed_ns / 1e9) : 0.0, ns_per_cycle);
+	fprintf(stderr, "%-12s %12s %12s %10s %10s %10s %10s\n", "point", "calls",
+			"total ms", "mean ns", "p50 ns", "p99 ns", "max ns");
+
+	for (int i = 0; i < NR_PROFILE_POINTS; i++) {
+		struct hist *h = &__points[i].hist;
+
+		if (!h->count) continue;
+
+		fprintf(stderr, "%-12s %12llu %12.3f %10.1f %10.0f %10.0f %10.0f\n",
+				__profile_point_sz[i], h->count,
+				__points[i].total * ns_per_cycle / 1e6,
+				__points[i].total * ns_per_cycle / h->count,
+				hist_percentile(h, 50) * ns_per_cycle,
+				hist_percentile(h, 99) * ns_per_cycle,
+				h->max * ns_per_cycle);
+	}
+	fprintf(stderr, "\n");
+}
+
+#endif
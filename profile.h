@@ -0,0 +1,89 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+/***********************************************************************
+ * Self-profiling of the simulator
+ *
+ * DESCRIPTION
+ *   Times each phase of a tick in __do_simulation() and each call to the
+ *   struct scheduler callbacks. Build with `make PROFILE=1` to enable it;
+ *   otherwise every macro below expands to nothing.
+ *
+ *   Samples are taken with rdtsc on x86 and clock_gettime() elsewhere.
+ *   The TSC is calibrated against CLOCK_MONOTONIC over the whole run.
+ *   The report goes to stderr at exit so that it stays out of the event
+ *   stream, and is left out with -q.
+ */
+enum profile_point {
+	PROFILE_TICK,			/* A whole iteration of the main loop */
+	PROFILE_FORK,			/* __fork_on_schedule() */
+	PROFILE_SCHEDULE,		/* Picking the next and retiring the previous */
+	PROFILE_ACQUIRE,		/* __run_current_acquire() */
+	PROFILE_RELEASE,		/* __run_current_release() */
+	PROFILE_OUTPUT,			/* Printing an event */
+
+	PROFILE_CB_SCHEDULE,	/* scheduler.schedule() */
+	PROFILE_CB_ACQUIRE,		/* scheduler.acquire() */
+	PROFILE_CB_RELEASE,		/* scheduler.release() */
+	PROFILE_CB_FORKED,		/* scheduler.forked() */
+	PROFILE_CB_EXITING,		/* scheduler.exiting() */
+
+	NR_PROFILE_POINTS,
+};
+
+#ifdef CONFIG_PROFILE
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+
+static inline unsigned long long profile_now(void)
+{
+	return __rdtsc();
+}
+#else
+unsigned long long profile_now(void);
+#endif
+
+void profile_record(enum profile_point point, unsigned long long cycles);
+void profile_begin(void);
+void profile_end(void);
+void profile_report(unsigned int nr_ticks);
+
+#define PROFILE_START(t)		unsigned long long t = profile_now()
+#define PROFILE_END(point, t)	profile_record(point, profile_now() - (t))
+
+/* Time a statement */
+#define PROFILE(point, stmt) do { \
+	PROFILE_START(__profile_t); \
+	stmt; \
+	PROFILE_END(point, __profile_t); \
+} while (0)
+
+#else
+
+#define profile_begin()			do { } while (0)
+#define profile_end()			do { } while (0)
+#define profile_report(nr_ticks)	do { } while (0)
+
+#define PROFILE_START(t)
+#define PROFILE_END(point, t)
+#define PROFILE(point, stmt)	do { stmt; } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,266 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#include "rbtree.h"
+
+static inline bool __is_red(const struct rb_node *node)
+{
+	return node && node->color == RB_RED;
+}
+
+/* Hook @new into the place of @old under the parent of @old */
+static void __replace_child(struct rb_root *root,
+		struct rb_node *old, struct rb_node *new)
+{
+	struct rb_node *parent = old->parent;
+
+	if (!parent) {
+		root->node = new;
+	} else if (parent->left == old) {
+		parent->left = new;
+	} else {
+		parent->right = new;
+	}
+	if (new) new->parent = parent;
+}
+
+/* Update the summaries from @node up to the root */
+static void __propagate(struct rb_node *node, const struct rb_augment *augment)
+{
+	for (; node; node = node->parent) {
+		augment->update(node);
+	}
+}
+
+static void __rotate_left(struct rb_root *root, struct rb_node *x,
+		const struct rb_augment *augment)
+{
+	struct rb_node *y = x->right;
+
+	x->right = y->left;
+	if (y->left) y->left->parent = x;
+	__replace_child(root, x, y);
+	y->left = x;
+	x->parent = y;
+
+	if (augment) {
+		augment->update(x);
+		augment->update(y);
+	}
+}
+
+static void __rotate_right(struct rb_root *root, struct rb_node *x,
+		const struct rb_augment *augment)
+{
+	struct rb_node *y = x->left;
+
+	x->left = y->right;
+	if (y->right) y->right->parent = x;
+	__replace_child(root, x, y);
+	y->right = x;
+	x->parent = y;
+
+	if (augment) {
+		augment->update(x);
+		augment->update(y);
+	}
+}
+
+struct rb_node *rb_next(const struct rb_node *node)
+{
+	struct rb_node *parent;
+
+	if (node->right) {
+		node = node->right;
+		while (node->left) node = node->left;
+		return (struct rb_node *)node;
+	}
+
+	while ((parent = node->parent) && node == parent->right) {
+		node = parent;
+	}
+	return parent;
+}
+
+void rb_add(struct rb_node *node, struct rb_root *root, rb_less_t less,
+		const struct rb_augment *augment)
+{
+	struct rb_node **link = &root->node;
+	struct rb_node *parent = NULL;
+	bool leftmost = true;
+
+	while (*link) {
+		parent = *link;
+		if (less(node, parent)) {
+			link = &parent->left;
+		} else {
+			link = &parent->right;
+			leftmost = false;
+		}
+	}
+
+	node->parent = parent;
+	node->left = node->right = NULL;
+	node->color = RB_RED;
+	*link = node;
+
+	if (leftmost) root->leftmost = node;
+	if (augment) __propagate(node, augment);
+
+	/* Resolve red-red violations going up */
+	while (__is_red(parent = node->parent)) {
+		struct rb_node *gparent = parent->parent;
+		struct rb_node *uncle;
+
+		if (parent == gparent->left) {
+			uncle = gparent->right;
+			if (__is_red(uncle)) {
+				parent->color = uncle->color = RB_BLACK;
+				gparent->color = RB_RED;
+				node = gparent;
+				continue;
+			}
+			if (node == parent->right) {
+				__rotate_left(root, parent, augment);
+				node = parent;
+				parent = node->parent;
+			}
+			parent->color = RB_BLACK;
+			gparent->color = RB_RED;
+			__rotate_right(root, gparent, augment);
+		} else {
+			uncle = gparent->left;
+			if (__is_red(uncle)) {
+				parent->color = uncle->color = RB_BLACK;
+				gparent->color = RB_RED;
+				node = gparent;
+				continue;
+			}
+			if (node == parent->left) {
+				__rotate_right(root, parent, augment);
+				node = parent;
+				parent = node->parent;
+			}
+			parent->color = RB_BLACK;
+			gparent->color = RB_RED;
+			__rotate_left(root, gparent, augment);
+		}
+	}
+	root->node->color = RB_BLACK;
+}
+
+/* Restore the black height after removing a black node above @node */
+static void __erase_fixup(struct rb_root *root, struct rb_node *node,
+		struct rb_node *parent, const struct rb_augment *augment)
+{
+	struct rb_node *sibling;
+
+	while (node != root->node && !__is_red(node)) {
+		if (node == parent->left) {
+			sibling = parent->right;
+			if (__is_red(sibling)) {
+				sibling->color = RB_BLACK;
+				parent->color = RB_RED;
+				__rotate_left(root, parent, augment);
+				sibling = parent->right;
+			}
+			if (!__is_red(sibling->left) && !__is_red(sibling->right)) {
+				sibling->color = RB_RED;
+				node = parent;
+				parent = node->parent;
+				continue;
+			}
+			if (!__is_red(sibling->right)) {
+				sibling->left->color = RB_BLACK;
+				sibling->color = RB_RED;
+				__rotate_right(root, sibling, augment);
+				sibling = parent->right;
+			}
+			sibling->color = parent->color;
+			parent->color = RB_BLACK;
+			sibling->right->color = RB_BLACK;
+			__rotate_left(root, parent, augment);
+		} else {
+			sibling = parent->left;
+			if (__is_red(sibling)) {
+				sibling->color = RB_BLACK;
+				parent->color = RB_RED;
+				__rotate_right(root, parent, augment);
+				sibling = parent->left;
+			}
+			if (!__is_red(sibling->left) && !__is_red(sibling->right)) {
+				sibling->color = RB_RED;
+				node = parent;
+				parent = node->parent;
+				continue;
+			}
+			if (!__is_red(sibling->left)) {
+				sibling->right->color = RB_BLACK;
+				sibling->color = RB_RED;
+				__rotate_left(root, sibling, augment);
+				sibling = parent->left;
+			}
+			sibling->color = parent->color;
+			parent->color = RB_BLACK;
+			sibling->left->color = RB_BLACK;
+			__rotate_right(root, parent, augment);
+		}
+		node = root->node;
+		break;
+	}
+	if (node) node->color = RB_BLACK;
+}
+
+void rb_erase(struct rb_node *node, struct rb_root *root,
+		const struct rb_augment *augment)
+{
+	struct rb_node *child, *parent;
+	int color;
+
+	if (root->leftmost == node) root->leftmost = rb_next(node);
+
+	if (!node->left || !node->right) {
+		/* Splice out @node itself */
+		child = node->left ? node->left : node->right;
+		parent = node->parent;
+		color = node->color;
+		__replace_child(root, node, child);
+	} else {
+		/* Splice out the successor, and put it in the place of @node */
+		struct rb_node *successor = node->right;
+
+		while (successor->left) successor = successor->left;
+
+		child = successor->right;
+		color = successor->color;
+		if (successor->parent == node) {
+			parent = successor;
+		} else {
+			parent = successor->parent;
+			__replace_child(root, successor, child);
+			successor->right = node->right;
+			successor->right->parent = successor;
+		}
+		__replace_child(root, node, successor);
+		successor->left = node->left;
+		successor->left->parent = successor;
+		successor->color = node->color;
+	}
+
+	if (augment) __propagate(parent, augment);
+	if (color == RB_BLACK) __erase_fixup(root, child, parent, augment);
+
+	RB_CLEAR_NODE(node);
+}
@@ -0,0 +1,98 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#ifndef __RBTREE_H__
+#define __RBTREE_H__
+
+#include <stddef.h>
+
+#include "types.h"
+
+/*
+ * Intrusive red-black tree in the spirit of the Linux rbtree.
+ *
+ * Embed struct rb_node in an entry and get the entry back with
+ * rb_entry(). The tree caches its leftmost node, so rb_first() is O(1),
+ * which is what the schedulers mostly ask for.
+ *
+ * A tree may be augmented with a per-node value summarizing its subtree
+ * (e.g., the minimum of some key under the node). Pass a struct
+ * rb_augment to rb_add() and rb_erase(); its @update is called on every
+ * node whose subtree changes, always on children before their parents.
+ * Pass NULL for plain trees.
+ */
+
+#define RB_RED		0
+#define RB_BLACK	1
+
+struct rb_node {
+	struct rb_node *parent;
+	struct rb_node *left;
+	struct rb_node *right;
+	int color;
+};
+
+struct rb_root {
+	struct rb_node *node;
+	struct rb_node *leftmost;
+};
+
+#define RB_ROOT_INIT { NULL, NULL }
+
+struct rb_augment {
+	/* Recompute the summary of @node from itself and its children */
+	void (*update)(struct rb_node *node);
+};
+
+/* Ordering of the tree. Equal nodes are placed after the existing ones */
+typedef bool (*rb_less_t)(const struct rb_node *a, const struct rb_node *b);
+
+#define rb_entry(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+static inline void INIT_RB_ROOT(struct rb_root *root)
+{
+	root->node = root->leftmost = NULL;
+}
+
+static inline bool rb_empty(const struct rb_root *root)
+{
+	return root->node == NULL;
+}
+
+/* Nodes off the tree point to themselves */
+static inline void RB_CLEAR_NODE(struct rb_node *node)
+{
+	node->parent = node;
+}
+
+static inline bool RB_EMPTY_NODE(const struct rb_node *node)
+{
+	return node->parent == node;
+}
+
+static inline struct rb_node *rb_first(const struct rb_root *root)
+{
+	return root->leftmost;
+}
+
+struct rb_node *rb_next(const struct rb_node *node);
+
+void rb_add(struct rb_node *node, struct rb_root *root, rb_less_t less,
+		const struct rb_augment *augment);
+void rb_erase(struct rb_node *node, struct rb_root *root,
+		const struct rb_augment *augment);
+
+#endif
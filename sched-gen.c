@@ -0,0 +1,486 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+/**
+ * Synthetic workload generator. Prints a process description file that
+ * the simulator accepts, drawn from the given distributions. The same
+ * parameters and seed always generate the same workload.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "types.h"
+#include "list_head.h"
+#include "resource.h"
+#include "prng.h"
+
+static struct prng prng;
+
+/**
+ * A distribution given as "kind:param,param,..."
+ */
+#define MAX_PARAMS	8
+
+struct dist {
+	char kind[16];
+	int nr_params;
+	double params[MAX_PARAMS];
+};
+
+static bool __parse_dist(const char *spec, struct dist *d)
+{
+	const char *colon = strchr(spec, ':');
+	const char *curr;
+	size_t len = colon ? colon - spec : strlen(spec);
+
+	if (len == 0 || len >= sizeof(d->kind)) return false;
+
+	memcpy(d->kind, spec, len);
+	d->kind[len] = '\0';
+	d->nr_params = 0;
+
+	for (curr = colon; curr && *curr; ) {
+		char *end;
+
+		if (d->nr_params == MAX_PARAMS) return false;
+		d->params[d->nr_params++] = strtod(curr + 1, &end);
+		if (end == curr + 1 || (*end != ',' && *end != '\0')) return false;
+		curr = *end ? end : NULL;
+	}
+	return true;
+}
+
+static inline bool __is(struct dist *d, const char *kind, int nr_params)
+{
+	return strcmp(d->kind, kind) == 0 && d->nr_params == nr_params;
+}
+
+static double __exponential(double mean)
+{
+	return -mean * log(1.0 - prng_double(&prng));
+}
+
+static double __pareto(double alpha, double min)
+{
+	return min / pow(1.0 - prng_double(&prng), 1.0 / alpha);
+}
+
+static unsigned int __at_least_one(double v)
+{
+	if (v < 1.0) return 1;
+	if (v > 1e9) return 1000000000;
+	return (unsigned int)(v + 0.5);
+}
+
+
+/***********************************************************************
+ * Arrivals
+ *
+ *   poisson:RATE         Processes arrive with the mean rate of RATE
+ *                        per tick
+ *   bursty:RATE,BURST    Bursts of BURST processes arrive at the same
+ *                        tick, keeping the mean rate of RATE per tick
+ */
+static struct dist arrival = { "poisson", 1, { 1.0 } };
+static double __clock = 0;
+static unsigned int __burst_left = 0;
+
+static bool __check_arrival(struct dist *d)
+{
+	return (__is(d, "poisson", 1) && d->params[0] > 0) ||
+		(__is(d, "bursty", 2) && d->params[0] > 0 && d->params[1] >= 1);
+}
+
+static unsigned int __next_arrival(void)
+{
+	if (__is(&arrival, "poisson", 1)) {
+		__clock += __exponential(1.0 / arrival.params[0]);
+	} else {
+		if (__burst_left == 0) {
+			__clock += __exponential(arrival.params[1] / arrival.params[0]);
+			__burst_left = (unsigned int)arrival.params[1];
+		}
+		__burst_left--;
+	}
+	return (unsigned int)__clock;
+}
+
+
+/***********************************************************************
+ * Lifespans
+ *
+ *   exp:MEAN             Exponential with the mean of MEAN ticks
+ *   pareto:ALPHA,MIN     Pareto with the shape ALPHA and the scale MIN
+ *   bimodal:S,L,P        S ticks with the probability P, L ticks otherwise
+ */
+static struct dist lifespan = { "exp", 1, { 10.0 } };
+
+static bool __check_lifespan(struct dist *d)
+{
+	return (__is(d, "exp", 1) && d->params[0] > 0) ||
+		(__is(d, "pareto", 2) && d->params[0] > 0 && d->params[1] > 0) ||
+		(__is(d, "bimodal", 3) && d->params[2] >= 0 && d->params[2] <= 1);
+}
+
+static unsigned int __next_lifespan(void)
+{
+	if (__is(&lifespan, "exp", 1)) {
+		return __at_least_one(__exponential(lifespan.params[0]));
+	} else if (__is(&lifespan, "pareto", 2)) {
+		return __at_least_one(__pareto(lifespan.params[0], lifespan.params[1]));
+	}
+	return __at_least_one(prng_double(&prng) < lifespan.params[2] ?
+			lifespan.params[0] : lifespan.params[1]);
+}
+
+
+/***********************************************************************
+ * Priorities
+ *
+ *   uniform:LO,HI        Uniform in [LO, HI]
+ *   classes:P,W,P,W,...  Priority P with the relative weight W
+ */
+static struct dist prio = { "uniform", 2, { 0, 0 } };
+
+static bool __check_prio(struct dist *d)
+{
+	if (__is(d, "uniform", 2)) return d->params[0] <= d->params[1];
+	return strcmp(d->kind, "classes") == 0 &&
+		d->nr_params >= 2 && d->nr_params % 2 == 0;
+}
+
+static unsigned int __next_prio(void)
+{
+	double total = 0, pick;
+	int i;
+
+	if (__is(&prio, "uniform", 2)) {
+		return prio.params[0] +
+			prng_below(&prng, prio.params[1] - prio.params[0] + 1);
+	}
+
+	for (i = 1; i < prio.nr_params; i += 2) {
+		total += prio.params[i];
+	}
+	pick = prng_double(&prng) * total;
+	for (i = 1; i < prio.nr_params - 2; i += 2) {
+		if (pick < prio.params[i]) break;
+		pick -= prio.params[i];
+	}
+	return (unsigned int)prio.params[i - 1];
+}
+
+
+/***********************************************************************
+ * Resource usage
+ *
+ *   Each process acquires up to @nr_acquires groups of resources one after
+ *   another. A group is a chain of up to @max_depth nested acquisitions,
+ *   each of which holds the resource for @mean_hold ticks on average. The
+ *   resources in a chain are acquired in the increasing order of their ids
+ *   to avoid deadlocks among processes, and every acquisition is released
+ *   before the process exits.
+ */
+static unsigned int nr_acquires = 0;
+static double mean_hold = 4.0;
+static unsigned int max_depth = 1;
+static unsigned int nr_resources = NR_RESOURCES;
+
+static void __pick_resources(unsigned int *ids, unsigned int nr)
+{
+	/* Choose @nr distinct ids out of @nr_resources in the increasing order */
+	unsigned int chosen = 0;
+
+	for (unsigned int i = 0; i < nr_resources && chosen < nr; i++) {
+		if (prng_below(&prng, nr_resources - i) < nr - chosen) {
+			ids[chosen++] = i;
+		}
+	}
+}
+
+static void __print_acquires(unsigned int lifespan)
+{
+	unsigned int nr_groups, segment;
+
+	if (!nr_acquires || lifespan < 2) return;
+
+	nr_groups = prng_below(&prng, nr_acquires + 1);
+	if (!nr_groups) return;
+
+	segment = lifespan / nr_groups;
+	if (segment < 1) return;
+
+	for (unsigned int g = 0; g < nr_groups; g++) {
+		unsigned int ids[NR_RESOURCES];
+		unsigned int depth = 1 + prng_below(&prng, max_depth);
+		unsigned int start = g * segment, end = start + segment;
+
+		if (depth > nr_resources) depth = nr_resources;
+		__pick_resources(ids, depth);
+
+		for (unsigned int d = 0; d < depth && start < end; d++) {
+			unsigned int hold = __at_least_one(__exponential(mean_hold));
+			unsigned int at = start + prng_below(&prng, end - start);
+
+			if (at + hold > end) hold = end - at;
+			printf("\tacquire %u %u %u\n", ids[d], at, hold);
+
+			/* The next one is nested in this one */
+			start = at;
+			end = at + hold;
+		}
+	}
+}
+
+
+/***********************************************************************
+ * Deadlines
+ *
+ *   With the probability @deadline_p, a process gets a deadline of its
+ *   lifespan times a slack drawn uniformly from [@slack_lo, @slack_hi]
+ */
+static double deadline_p = 0;
+static double slack_lo, slack_hi;
+
+static bool __parse_deadline(const char *spec)
+{
+	struct dist d;
+
+	if (!__parse_dist(spec, &d) || !__is(&d, "slack", 3)) return false;
+	if (d.params[0] < 0 || d.params[0] > 1) return false;
+	if (d.params[1] < 1 || d.params[1] > d.params[2]) return false;
+
+	deadline_p = d.params[0];
+	slack_lo = d.params[1];
+	slack_hi = d.params[2];
+	return true;
+}
+
+static void __print_deadline(unsigned int lifespan)
+{
+	double slack;
+
+	if (!deadline_p || prng_double(&prng) >= deadline_p) return;
+
+	slack = slack_lo + (slack_hi - slack_lo) * prng_double(&prng);
+	printf("\tdeadline %u\n", __at_least_one(ceil(lifespan * slack)));
+}
+
+
+/***********************************************************************
+ * Periodic processes
+ *
+ *   With the probability @period_p, a process releases a job every period
+ *   of @period_base times 2^[0, @period_levels), with the WCET of its
+ *   lifespan clipped to the period. The periods are harmonic to keep the
+ *   hyperperiod within @period_base * 2^(@period_levels - 1) ticks
+ */
+static double period_p = 0;
+static unsigned int period_base, period_levels;
+
+static bool __parse_period(const char *spec)
+{
+	struct dist d;
+
+	if (!__parse_dist(spec, &d) || !__is(&d, "harmonic", 3)) return false;
+	if (d.params[0] < 0 || d.params[0] > 1) return false;
+	if (d.params[1] < 1 || d.params[2] < 1 || d.params[2] > 16) return false;
+
+	period_p = d.params[0];
+	period_base = d.params[1];
+	period_levels = d.params[2];
+	return true;
+}
+
+/* Returns the lifespan of each job, or @lifespan for one-shot processes */
+static unsigned int __print_period(unsigned int lifespan)
+{
+	unsigned int period;
+
+	if (!period_p || prng_double(&prng) >= period_p) return lifespan;
+
+	period = period_base << prng_below(&prng, period_levels);
+	if (lifespan > period) lifespan = period;
+
+	printf("\tperiod %u\n", period);
+	printf("\twcet %u\n", lifespan);
+	return lifespan;
+}
+
+
+/***********************************************************************
+ * I/O phases
+ *
+ *   Split the lifespan into up to @io_bursts CPU phases of even lengths,
+ *   with I/O phases of exponential lengths with the mean of @io_mean in
+ *   between. Without them, the lifespan is given as is
+ */
+static unsigned int io_bursts = 0;
+static double io_mean;
+
+static bool __parse_io(const char *spec)
+{
+	struct dist d;
+
+	if (!__parse_dist(spec, &d) || !__is(&d, "bursts", 2)) return false;
+	if (d.params[0] < 1 || d.params[1] <= 0) return false;
+
+	io_bursts = d.params[0];
+	io_mean = d.params[1];
+	return true;
+}
+
+static void __print_phases(unsigned int lifespan)
+{
+	unsigned int nr_phases = io_bursts < lifespan ? io_bursts : lifespan;
+
+	if (!io_bursts) {
+		printf("\tlifespan %u\n", lifespan);
+		return;
+	}
+
+	for (unsigned int i = 0; i < nr_phases; i++) {
+		if (i) printf("\tio %u\n", __at_least_one(__exponential(io_mean)));
+		printf("\tcpu %u\n", lifespan / nr_phases + (i < lifespan % nr_phases));
+	}
+}
+
+
+static void __print_usage(char * const name)
+{
+	printf("Usage: %s [options]\n", name);
+	printf("\n");
+	printf("  -n NR      : Number of processes (default: 100)\n");
+	printf("  -s SEED    : Seed of the random number generator (default: 0)\n");
+	printf("  -a ARRIVAL : poisson:RATE (default: poisson:1)\n");
+	printf("               bursty:RATE,BURST\n");
+	printf("  -l LIFESPAN: exp:MEAN (default: exp:10)\n");
+	printf("               pareto:ALPHA,MIN\n");
+	printf("               bimodal:SHORT,LONG,P_SHORT\n");
+	printf("  -p PRIO    : uniform:LO,HI (default: uniform:0,0)\n");
+	printf("               classes:PRIO,WEIGHT,PRIO,WEIGHT,...\n");
+	printf("  -r NR      : Max number of resource acquisitions per process (default: 0)\n");
+	printf("  -t TICKS   : Mean ticks to hold a resource (default: 4)\n");
+	printf("  -d DEPTH   : Max nesting depth of acquisitions (default: 1)\n");
+	printf("  -R NR      : Number of resources to use (default: %d)\n", NR_RESOURCES);
+	printf("  -D DEADLINE: slack:P,LO,HI to give deadlines of lifespan * [LO, HI]\n");
+	printf("               to processes with the probability P (default: none)\n");
+	printf("  -I IO      : bursts:K,MEAN to split lifespans into K CPU phases with\n");
+	printf("               I/O of MEAN ticks on average in between (default: none)\n");
+	printf("  -T PERIOD  : harmonic:P,BASE,N to make processes periodic with the\n");
+	printf("               probability P, with periods of BASE * 2^[0, N) (default: none)\n");
+	printf("\n");
+}
+
+int main(int argc, char * const argv[])
+{
+	int opt;
+	unsigned long long nr_processes = 100;
+	unsigned long long seed = 0;
+
+	while ((opt = getopt(argc, argv, "n:s:a:l:p:r:t:d:R:D:I:T:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			nr_processes = strtoull(optarg, NULL, 0);
+			break;
+		case 's':
+			seed = strtoull(optarg, NULL, 0);
+			break;
+		case 'a':
+			if (!__parse_dist(optarg, &arrival) || !__check_arrival(&arrival)) {
+				fprintf(stderr, "Invalid arrival %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'l':
+			if (!__parse_dist(optarg, &lifespan) || !__check_lifespan(&lifespan)) {
+				fprintf(stderr, "Invalid lifespan %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'p':
+			if (!__parse_dist(optarg, &prio) || !__check_prio(&prio)) {
+				fprintf(stderr, "Invalid priority %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'r':
+			nr_acquires = atoi(optarg);
+			break;
+		case 't':
+			mean_hold = atof(optarg);
+			break;
+		case 'd':
+			max_depth = atoi(optarg);
+			break;
+		case 'R':
+			nr_resources = atoi(optarg);
+			if (nr_resources < 1 || nr_resources > NR_RESOURCES) {
+				fprintf(stderr, "Number of resources should be 1 - %d\n", NR_RESOURCES);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'D':
+			if (!__parse_deadline(optarg)) {
+				fprintf(stderr, "Invalid deadline %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'I':
+			if (!__parse_io(optarg)) {
+				fprintf(stderr, "Invalid I/O %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'T':
+			if (!__parse_period(optarg)) {
+				fprintf(stderr, "Invalid period %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'h':
+		default:
+			__print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (max_depth < 1) max_depth = 1;
+
+	prng_seed(&prng, seed);
+
+	printf("# sched-gen -n %llu -s %llu\n\n", nr_processes, seed);
+
+	for (unsigned long long pid = 1; pid <= nr_processes; pid++) {
+		unsigned int start = __next_arrival();
+		unsigned int life = __next_lifespan();
+
+		printf("process %llu\n", pid);
+		printf("\tstart %u\n", start);
+		life = __print_period(life);
+		__print_phases(life);
+		printf("\tprio %u\n", __next_prio());
+		__print_deadline(life);
+		__print_acquires(life);
+		printf("end\n\n");
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -22,6 +22,9 @@
 #include <assert.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <stdarg.h>
+#include <time.h>
+#include <sys/resource.h>
 
 #include "types.h"
 #include "list_head.h"
@@ -29,6 +32,11 @@
 #include "parser.h"
 #include "process.h"
 #include "resource.h"
+#include "pool.h"
+#include "soa.h"
+#include "metrics.h"
+#include "profile.h"
+#include "heap.h"
 
 #include "sched.h"
 
@@ -59,13 +67,147 @@ struct resource_schedule {
 	int resource_id;
 	int at;
 	int duration;
-	struct list_head list;
+	struct ilist_node list;
 };
 
+#define __rs_list	offsetof(struct resource_schedule, list)
+
+/**
+ * I/O phase of a process. The process sleeps for @duration ticks once it
+ * has run for @at ticks
+ */
+struct io_schedule {
+	unsigned int at;
+	unsigned int duration;
+	struct ilist_node list;
+};
+
+#define __io_list	offsetof(struct io_schedule, list)
+
 static LIST_HEAD(__forkqueue);
 
+/**
+ * Processes sleeping for I/O, keyed by the tick to wake up at
+ */
+static struct heap __sleepqueue = HEAP_INIT;
+
+/**
+ * Slabs for processes, resource schedules, and I/O schedules
+ */
+static struct pool __process_pool;
+static struct pool __resource_schedule_pool;
+static struct pool __io_schedule_pool;
+
 bool quiet = false;
 
+/**
+ * Print the statistics of the simulator itself at exit. True if the program
+ * was started with -T option
+ */
+static bool stats = false;
+
+/**
+ * Cost of a context switch in 1/SWITCH_COST_SCALE ticks (-x option).
+ * Costs of switches are accumulated in @__switch_debt, and every whole tick
+ * of it is charged to the process being switched in
+ */
+#define SWITCH_COST_SCALE	1000
+static unsigned int switch_cost = 0;
+static unsigned int __switch_debt = 0;
+
+/**
+ * File to dump the raw buckets of the latency histograms into (-b option)
+ */
+static char *histogram_dump = NULL;
+
+/**
+ * Format of the event stream on stderr. The column format indents each
+ * event by the pid, which is handy for small testcases but costs O(pid)
+ * per event. The compact format prints the pid as a field instead.
+ * The none format drops the stream altogether so that benchmarks measure
+ * the scheduling paths rather than stdio.
+ */
+enum output_format {
+	OUTPUT_COLUMN,
+	OUTPUT_COMPACT,
+	OUTPUT_RLE,
+	OUTPUT_NONE,
+};
+
+static enum output_format output = OUTPUT_COLUMN;
+
+static const char * __output_format_sz[] = {
+	"column",
+	"compact",
+	"rle",
+	"none",
+};
+
+/**
+ * Periodic processes release a job every period until @horizon. By default
+ * the horizon is one hyperperiod (the LCM of the periods) past the latest
+ * first release, which is enough to tell whether the task set meets its
+ * deadlines. Hyperperiods longer than HYPERPERIOD_MAX are clipped to it.
+ * The -P option sets the horizon explicitly.
+ */
+#define HYPERPERIOD_MAX	(1U << 20)
+static unsigned int horizon = 0;
+
+/**
+ * Number of events generated so far, regardless of the output format
+ */
+static unsigned long long __nr_events = 0;
+
+/**
+ * Rolling digest of the event stream (-d option). Each event is folded in
+ * as (tick, pid, format, argument) with FNV-1a over 32-bit words, so the
+ * digest does not depend on the output format. With a non-zero
+ * @digest_interval, the digest so far is printed every that many ticks
+ * to localize a divergence between two runs to a window of ticks.
+ */
+#define DIGEST_OFFSET	0xcbf29ce484222325ULL
+#define DIGEST_PRIME	0x100000001b3ULL
+static bool digest = false;
+static unsigned int digest_interval = 0;
+static unsigned long long __digest = DIGEST_OFFSET;
+static unsigned int __next_checkpoint = 0;
+
+static inline void __digest_word(unsigned int word)
+{
+	__digest = (__digest ^ word) * DIGEST_PRIME;
+}
+
+static void __digest_event(unsigned int pid, const char *format, ...)
+{
+	va_list args;
+
+	__digest_word(ticks);
+	__digest_word(pid);
+
+	va_start(args, format);
+	for (const char *c = format; *c; c++) {
+		if (*c == '%') {
+			c++;
+			__digest_word(va_arg(args, unsigned int));
+		} else {
+			__digest_word(*c);
+		}
+	}
+	va_end(args);
+}
+
+static void __checkpoint(void)
+{
+	printf("checkpoint %u %016llx\n", ticks, __digest);
+	__next_checkpoint = (ticks / digest_interval + 1) * digest_interval;
+}
+
+/**
+ * Wall-clock time spent to load the script and to simulate, in ns
+ */
+static unsigned long long __load_ns = 0;
+static unsigned long long __simulation_ns = 0;
+
 static const char * __process_status_sz[] = {
 	"RDY",
 	"RUN",
@@ -84,6 +226,17 @@ extern struct scheduler prio_scheduler;
 extern struct scheduler pa_scheduler;
 extern struct scheduler pcp_scheduler;
 extern struct scheduler pip_scheduler;
+extern struct scheduler cfs_scheduler;
+extern struct scheduler eevdf_scheduler;
+extern struct scheduler mlfq_scheduler;
+extern struct scheduler edf_scheduler;
+extern struct scheduler rm_scheduler;
+extern struct scheduler lottery_scheduler;
+extern struct scheduler stride_scheduler;
+extern struct scheduler o1_scheduler;
+extern struct scheduler psjf_scheduler;
+extern struct scheduler psrtf_scheduler;
+extern struct scheduler hrrn_scheduler;
 
 static struct scheduler *sched = &fifo_scheduler;
 
@@ -103,7 +256,7 @@ void dump_status(void)
 	list_for_each_entry(p, &readyqueue, list) {
 		printf("%2d (%s): %d + %d/%d at %d\n",
 				p->pid, __process_status_sz[p->status],
-				p->__starts_at, p->age, p->lifespan, p->prio);
+				p->__starts_at, p->age, p->lifespan, ready_prio(p));
 	}
 
 	printf("***** RESOURCES *******\n");
@@ -127,14 +280,99 @@ void dump_status(void)
 	return;
 }
 
+/**
+ * Run-length record pending in the rle format. Consecutive ticks where
+ * the same process runs (or the processor idles) without any other event
+ * in between are collapsed into a single record.
+ */
+static struct {
+	bool pending;
+	bool idle;
+	unsigned int pid;
+	unsigned int since;
+	unsigned int count;
+} __run;
+
+static void __flush_run(void)
+{
+	if (!__run.pending) return;
+
+	if (__run.idle) {
+		if (__run.count > 1) {
+			fprintf(stderr, "%3d: idle x%d\n", __run.since, __run.count);
+		} else {
+			fprintf(stderr, "%3d: idle\n", __run.since);
+		}
+	} else {
+		if (__run.count > 1) {
+			fprintf(stderr, "%3d-%d: %d runs\n",
+					__run.since, __run.since + __run.count - 1, __run.pid);
+		} else {
+			fprintf(stderr, "%3d: %d %d\n", __run.since, __run.pid, __run.pid);
+		}
+	}
+	__run.pending = false;
+}
+
 #define __print_event(pid, string, args...) do { \
-	fprintf(stderr, "%3d: ", ticks); \
-	for (int i = 0; i < pid; i++) { \
-		fprintf(stderr, "    "); \
+	PROFILE_START(__output_t); \
+	__nr_events++; \
+	if (digest) __digest_event(pid, string, ##args); \
+	if (output == OUTPUT_NONE) { \
+		/* Count the event only */ \
+	} else if (output != OUTPUT_COLUMN) { \
+		if (output == OUTPUT_RLE) __flush_run(); \
+		fprintf(stderr, "%3d: %d " string "\n", ticks, pid, ##args); \
+	} else { \
+		fprintf(stderr, "%3d: ", ticks); \
+		for (int i = 0; i < pid; i++) { \
+			fprintf(stderr, "    "); \
+		} \
+		fprintf(stderr, string "\n", ##args); \
 	} \
-	fprintf(stderr, string "\n", ##args); \
+	PROFILE_END(PROFILE_OUTPUT, __output_t); \
 } while (0);
 
+static void __extend_run(bool idle, unsigned int pid)
+{
+	if (__run.pending && __run.idle == idle && __run.pid == pid &&
+			__run.since + __run.count == ticks) {
+		__run.count++;
+		return;
+	}
+
+	PROFILE(PROFILE_OUTPUT, __flush_run());
+
+	__run.pending = true;
+	__run.idle = idle;
+	__run.pid = pid;
+	__run.since = ticks;
+	__run.count = 1;
+}
+
+static void __print_run(unsigned int pid)
+{
+	if (output == OUTPUT_RLE) {
+		__nr_events++;
+		if (digest) __digest_event(pid, "%d", pid);
+		__extend_run(false, pid);
+		return;
+	}
+	__print_event(pid, "%d", pid);
+}
+
+static void __print_idle(void)
+{
+	__nr_events++;
+	if (digest) __digest_event(0, "idle");
+	if (output == OUTPUT_NONE) return;
+	if (output == OUTPUT_RLE) {
+		__extend_run(true, 0);
+		return;
+	}
+	PROFILE(PROFILE_OUTPUT, fprintf(stderr, "%3d: idle\n", ticks));
+}
+
 static inline bool strmatch(char * const str, const char *expect)
 {
 	return (strlen(str) == strlen(expect)) && (strncmp(str, expect, strlen(expect)) == 0);
@@ -142,7 +380,7 @@ static inline bool strmatch(char * const str, const char *expect)
 
 static void __briefing_process(struct process *p)
 {
-	struct resource_schedule *rs;
+	unsigned int i;
 
 	if (quiet) return;
 
@@ -150,9 +388,70 @@ static void __briefing_process(struct process *p)
 				p->pid, p->__starts_at, p->lifespan,
 				p->lifespan >= 2 ? "s" : "", p->prio);
 
-	list_for_each_entry(rs, &p->__resources_to_acquire, list) {
+	if (p->period) {
+		printf("    Release a job every %d tick%s", p->period,
+				p->period >= 2 ? "s" : "");
+		if (p->wcet) printf(" with WCET %d", p->wcet);
+		printf("\n");
+	}
+
+	if (p->deadline) {
+		printf("    Complete by tick %d\n", p->deadline);
+	}
+
+	if (p->tickets) {
+		printf("    Hold %d ticket%s\n", p->tickets, p->tickets >= 2 ? "s" : "");
+	}
+
+	if (p->slice) {
+		printf("    Request slices of %d tick%s\n", p->slice,
+				p->slice >= 2 ? "s" : "");
+	}
+
+	ilist_for_each(&__resource_schedule_pool, __rs_list, i, &p->__resources_to_acquire) {
+		struct resource_schedule *rs =
+				ilist_entry(&__resource_schedule_pool, i, struct resource_schedule);
 		printf("    Acquire resource %d at %d for %d\n", rs->resource_id, rs->at, rs->duration);
 	}
+
+	ilist_for_each(&__io_schedule_pool, __io_list, i, &p->__io_phases) {
+		struct io_schedule *io =
+				ilist_entry(&__io_schedule_pool, i, struct io_schedule);
+		printf("    Do I/O at %d for %d\n", io->at, io->duration);
+	}
+}
+
+/**
+ * Add an I/O phase of @duration ticks after the CPU phases so far. Phases
+ * without CPU in between are merged, and those before the first CPU phase
+ * delay the fork.
+ */
+static void __add_io_phase(struct process *p, unsigned int duration)
+{
+	struct pool *pool = &__io_schedule_pool;
+	struct io_schedule *io;
+	unsigned int i;
+
+	if (!duration) return;
+
+	if (!p->lifespan) {
+		p->__starts_at += duration;
+		return;
+	}
+
+	if (!ilist_empty(&p->__io_phases)) {
+		io = ilist_entry(pool, p->__io_phases.last, struct io_schedule);
+		if (io->at == p->lifespan) {
+			io->duration += duration;
+			return;
+		}
+	}
+
+	i = pool_alloc_index(pool);
+	io = ilist_entry(pool, i, struct io_schedule);
+	io->at = p->lifespan;
+	io->duration = duration;
+	ilist_add_tail(pool, __io_list, i, &p->__io_phases);
 }
 
 static int __load_script(char * const filename)
@@ -172,14 +471,16 @@ static int __load_script(char * const filename)
 		if (strmatch(tokens[0], "process")) {
 			assert(nr_tokens == 2);
 			/* Start processor description */
-			p = malloc(sizeof(*p));
+			p = pool_alloc(&__process_pool);
 			memset(p, 0x00, sizeof(*p));
 
 			p->pid = atoi(tokens[1]);
+			p->__ready_slot = SOA_NO_SLOT;
 
 			INIT_LIST_HEAD(&p->list);
-			INIT_LIST_HEAD(&p->__resources_to_acquire);
-			INIT_LIST_HEAD(&p->__resources_holding);
+			INIT_ILIST_HEAD(&p->__resources_to_acquire);
+			INIT_ILIST_HEAD(&p->__resources_holding);
+			INIT_ILIST_HEAD(&p->__io_phases);
 
 			continue;
 		} else if (strmatch(tokens[0], "end")) {
@@ -187,9 +488,27 @@ static int __load_script(char * const filename)
 			struct resource_schedule *rs;
 			assert(p);
 
+			/* Jobs run for their WCET and are due by the next release by default */
+			if (p->wcet && !p->lifespan) p->lifespan = p->wcet;
+			if (p->period && !p->deadline) p->deadline = p->period;
+
+			if (p->deadline) p->deadline += p->__starts_at;
+
+			/* I/O after the last CPU phase does not affect scheduling */
+			if (!ilist_empty(&p->__io_phases)) {
+				unsigned int last = p->__io_phases.last;
+
+				if (ilist_entry(&__io_schedule_pool, last,
+							struct io_schedule)->at >= p->lifespan) {
+					ilist_del(&__io_schedule_pool, __io_list, last, &p->__io_phases);
+					pool_free_index(&__io_schedule_pool, last);
+				}
+			}
 			list_add_tail(&p->list, &__forkqueue);
 
 			__briefing_process(p);
+
+			if (!p->tickets) p->tickets = p->prio + 1;
 			p = NULL;
 
 			continue;
@@ -201,20 +520,45 @@ static int __load_script(char * const filename)
 		} else if (strmatch(tokens[0], "prio")) {
 			assert(nr_tokens == 2);
 			p->prio = p->prio_orig = atoi(tokens[1]);
+		} else if (strmatch(tokens[0], "deadline")) {
+			/* Relative to the start. Made absolute at the end */
+			assert(nr_tokens == 2);
+			p->deadline = atoi(tokens[1]);
+		} else if (strmatch(tokens[0], "period")) {
+			assert(nr_tokens == 2);
+			p->period = atoi(tokens[1]);
+		} else if (strmatch(tokens[0], "wcet")) {
+			assert(nr_tokens == 2);
+			p->wcet = atoi(tokens[1]);
+		} else if (strmatch(tokens[0], "tickets")) {
+			assert(nr_tokens == 2);
+			p->tickets = atoi(tokens[1]);
+		} else if (strmatch(tokens[0], "slice")) {
+			assert(nr_tokens == 2);
+			p->slice = atoi(tokens[1]);
+		} else if (strmatch(tokens[0], "cpu")) {
+			assert(nr_tokens == 2);
+			p->lifespan += atoi(tokens[1]);
+		} else if (strmatch(tokens[0], "io")) {
+			assert(nr_tokens == 2);
+			__add_io_phase(p, atoi(tokens[1]));
 		} else if (strmatch(tokens[0], "start")) {
 			assert(nr_tokens == 2);
 			p->__starts_at = atoi(tokens[1]);
 		} else if (strmatch(tokens[0], "acquire")) {
 			struct resource_schedule *rs;
+			unsigned int i;
 			assert(nr_tokens == 4);
 
-			rs = malloc(sizeof(*rs));
+			i = pool_alloc_index(&__resource_schedule_pool);
+			rs = ilist_entry(&__resource_schedule_pool, i, struct resource_schedule);
 
 			rs->resource_id = atoi(tokens[1]);
 			rs->at = atoi(tokens[2]);
 			rs->duration = atoi(tokens[3]);
 
-			list_add_tail(&rs->list, &p->__resources_to_acquire);
+			ilist_add_tail(&__resource_schedule_pool, __rs_list, i,
+					&p->__resources_to_acquire);
 		} else {
 			fprintf(stderr, "Unknown property %s\n", tokens[0]);
 			return false;
@@ -226,6 +570,92 @@ static int __load_script(char * const filename)
 }
 
 
+static unsigned long long __gcd(unsigned long long a, unsigned long long b)
+{
+	while (b) {
+		unsigned long long t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/**
+ * Set the horizon of periodic releases to one hyperperiod past the latest
+ * first release unless given with -P
+ */
+static void __set_horizon(void)
+{
+	struct process *p;
+	unsigned long long hyperperiod = 1;
+	unsigned int last_start = 0;
+	bool periodic = false;
+
+	list_for_each_entry(p, &__forkqueue, list) {
+		if (!p->period) continue;
+
+		periodic = true;
+		if (p->__starts_at > last_start) last_start = p->__starts_at;
+		if (hyperperiod <= HYPERPERIOD_MAX) {
+			hyperperiod = hyperperiod / __gcd(hyperperiod, p->period) * p->period;
+		}
+	}
+
+	if (!periodic || horizon) return;
+
+	if (hyperperiod > HYPERPERIOD_MAX) {
+		fprintf(stderr, "Hyperperiod exceeds %u ticks. Releasing jobs up to it\n",
+				HYPERPERIOD_MAX);
+		hyperperiod = HYPERPERIOD_MAX;
+	}
+	horizon = last_start + hyperperiod;
+
+	if (quiet) return;
+	printf("- Release periodic jobs until tick %u (hyperperiod %llu)\n\n",
+			horizon, hyperperiod);
+}
+
+/**
+ * Queue the next job of the periodic process @p to fork a period later.
+ * The job is a copy of @p, along with its schedule to acquire resources
+ */
+static void __release_next_job(struct process *p)
+{
+	struct pool *pool = &__resource_schedule_pool;
+	struct process *job;
+	unsigned int i;
+
+	if (!horizon || p->__starts_at + p->period >= horizon) return;
+
+	job = pool_alloc(&__process_pool);
+	*job = *p;
+	job->__starts_at += p->period;
+	if (job->deadline) job->deadline += p->period;
+
+	INIT_LIST_HEAD(&job->list);
+	INIT_ILIST_HEAD(&job->__resources_to_acquire);
+	INIT_ILIST_HEAD(&job->__resources_holding);
+
+	ilist_for_each(pool, __rs_list, i, &p->__resources_to_acquire) {
+		unsigned int j = pool_alloc_index(pool);
+
+		*ilist_entry(pool, j, struct resource_schedule) =
+				*ilist_entry(pool, i, struct resource_schedule);
+		ilist_add_tail(pool, __rs_list, j, &job->__resources_to_acquire);
+	}
+
+	INIT_ILIST_HEAD(&job->__io_phases);
+	ilist_for_each(&__io_schedule_pool, __io_list, i, &p->__io_phases) {
+		unsigned int j = pool_alloc_index(&__io_schedule_pool);
+
+		*ilist_entry(&__io_schedule_pool, j, struct io_schedule) =
+				*ilist_entry(&__io_schedule_pool, i, struct io_schedule);
+		ilist_add_tail(&__io_schedule_pool, __io_list, j, &job->__io_phases);
+	}
+
+	list_add_tail(&job->list, &__forkqueue);
+}
+
 /**
  * Fork process on schedule
  */
@@ -235,10 +665,13 @@ static int __fork_on_schedule()
 	struct process *p, *tmp;
 	list_for_each_entry_safe(p, tmp, &__forkqueue, list) {
 		if (p->__starts_at <= ticks) {
-			list_move_tail(&p->list, &readyqueue);
+			list_del_init(&p->list);
+			if (p->period) __release_next_job(p);
+			metrics_fork(p);
+			ready_enqueue(p);
 			p->status = PROCESS_READY;
 			__print_event(p->pid, "N");
-			if (sched->forked) sched->forked(p);
+			if (sched->forked) PROFILE(PROFILE_CB_FORKED, sched->forked(p));
 			nr_forked++;
 		}
 	}
@@ -254,16 +687,21 @@ static void __exit_process(struct process *p)
 	assert(list_empty(&p->list));
 
 	/* Make sure the process is not holding any resource */
-	assert(list_empty(&p->__resources_holding));
+	assert(ilist_empty(&p->__resources_holding));
 
 	/* Make sure there is no pending resource to acquire */
-	assert(list_empty(&p->__resources_to_acquire));
+	assert(ilist_empty(&p->__resources_to_acquire));
 
-	if (sched->exiting) sched->exiting(p);
+	/* Make sure there is no pending I/O */
+	assert(ilist_empty(&p->__io_phases));
+
+	if (sched->exiting) PROFILE(PROFILE_CB_EXITING, sched->exiting(p));
 
 	__print_event(p->pid, "X");
 
-	free(p);
+	metrics_exit(p);
+
+	pool_free(&__process_pool, p);
 }
 
 
@@ -272,18 +710,28 @@ static void __exit_process(struct process *p)
  */
 static bool __run_current_acquire()
 {
-	struct resource_schedule *rs, *tmp;
+	struct pool *pool = &__resource_schedule_pool;
+	unsigned int i, tmp;
+
+	ilist_for_each_safe(pool, __rs_list, i, tmp, &current->__resources_to_acquire) {
+		struct resource_schedule *rs =
+				ilist_entry(pool, i, struct resource_schedule);
 
-	list_for_each_entry_safe(rs, tmp, &current->__resources_to_acquire, list) {
 		if (rs->at == current->age) {
+			bool acquired;
 			assert(sched->acquire && "scheduler.acquire() not implemented");
 
 			/* Callback to acquire the resource */
-			if (sched->acquire(rs->resource_id)) {
-				list_move_tail(&rs->list, &current->__resources_holding);
+			PROFILE(PROFILE_CB_ACQUIRE, acquired = sched->acquire(rs->resource_id));
+			if (acquired) {
+				ilist_move_tail(pool, __rs_list, i,
+						&current->__resources_to_acquire,
+						&current->__resources_holding);
+				metrics_acquire(current, rs->resource_id);
 
 				__print_event(current->pid, "+%d", rs->resource_id);
 			} else {
+				metrics_block(current, rs->resource_id);
 				return false;
 			}
 		}
@@ -292,29 +740,116 @@ static bool __run_current_acquire()
 	return true;
 }
 
+/**
+ * The release() callback puts the woken waiters at the tail of the ready
+ * queue. They still have the tick they started waiting, which the others
+ * in the ready queue do not.
+ */
+static void __account_wakeups(void)
+{
+	struct process *p;
+
+	list_for_each_entry_reverse(p, &readyqueue, list) {
+		if (p->__wait_since == METRICS_NONE) break;
+		metrics_wakeup(p);
+	}
+}
+
 /**
  * Process resource release
  */
 static void __run_current_release()
 {
-	struct resource_schedule *rs, *tmp;
+	struct pool *pool = &__resource_schedule_pool;
+	unsigned int i, tmp;
+
+	ilist_for_each_safe(pool, __rs_list, i, tmp, &current->__resources_holding) {
+		struct resource_schedule *rs =
+				ilist_entry(pool, i, struct resource_schedule);
 
-	list_for_each_entry_safe(rs, tmp, &current->__resources_holding, list) {
 		if (--rs->duration == 0) {
 			assert(sched->release && "scheduler.release() not implemented");
 
 			/* Callback the release() */
-			sched->release(rs->resource_id);
+			PROFILE(PROFILE_CB_RELEASE, sched->release(rs->resource_id));
+			metrics_release(rs->resource_id);
+			__account_wakeups();
 
 			__print_event(current->pid, "-%d", rs->resource_id);
 
-			list_del(&rs->list);
-			free(rs);
+			ilist_del(pool, __rs_list, i, &current->__resources_holding);
+			pool_free_index(pool, i);
 		}
 	}
 }
 
 
+/**
+ * Put @current to sleep if it has finished a CPU phase followed by I/O.
+ * It is in the wait status as if blocked on a resource, but is kept in the
+ * sleep queue of the framework rather than in a waitqueue
+ */
+static void __run_current_io(void)
+{
+	struct pool *pool = &__io_schedule_pool;
+	unsigned int i = current->__io_phases.first;
+	struct io_schedule *io;
+
+	if (i == ILIST_NIL) return;
+
+	io = ilist_entry(pool, i, struct io_schedule);
+	if (io->at != current->age) return;
+
+	current->status = PROCESS_WAIT;
+	heap_push(&__sleepqueue, ticks + 1 + io->duration, current);
+	metrics_sleep(current);
+	__print_event(current->pid, "I");
+
+	ilist_del(pool, __io_list, i, &current->__io_phases);
+	pool_free_index(pool, i);
+}
+
+/**
+ * Wake up the processes completing I/O at this tick onto the readyqueue
+ */
+static void __wake_sleepers(void)
+{
+	while (!heap_empty(&__sleepqueue) && heap_peek_key(&__sleepqueue) <= ticks) {
+		struct process *p = heap_pop(&__sleepqueue);
+
+		assert(p->status == PROCESS_WAIT);
+		p->status = PROCESS_READY;
+		metrics_io_wakeup(p);
+		__print_event(p->pid, "W");
+		ready_enqueue(p);
+	}
+}
+
+
+/**
+ * Charge the cost of switching into @current. The processor spends the
+ * whole ticks of the accumulated cost on switching, during which @current
+ * makes no progress while I/O still completes, the processes on schedule
+ * are still forked, and the windows of the share error still close.
+ */
+static void __switch_context(void)
+{
+	__switch_debt += switch_cost;
+
+	while (__switch_debt >= SWITCH_COST_SCALE) {
+		__switch_debt -= SWITCH_COST_SCALE;
+
+		__print_event(current->pid, "~");
+		metrics_switch_overhead(current);
+
+		ticks++;
+		if (share_window && ticks % share_window == 0) metrics_share_window();
+		__wake_sleepers();
+		__fork_on_schedule();
+	}
+}
+
+
 /***********************************************************************
  * The main loop for the scheduler simulation
  */
@@ -324,13 +859,17 @@ static void __do_simulation(void)
 
 	while (true) {
 		struct process *prev;
+		bool acquired;
+		PROFILE_START(tick);
 
-		/* Fork processes on schedule */
-		__fork_on_schedule();
+		/* Wake up processes completing I/O, and fork processes on schedule */
+		__wake_sleepers();
+		PROFILE(PROFILE_FORK, __fork_on_schedule());
 
 		/* Ask scheduler to pick the next process to run */
+		PROFILE_START(schedule);
 		prev = current;
-		current = sched->schedule();
+		PROFILE(PROFILE_CB_SCHEDULE, current = sched->schedule());
 
 		/* If the system ran a process in the previous tick, */
 		if (prev) {
@@ -345,34 +884,43 @@ static void __do_simulation(void)
 				__exit_process(prev);
 			}
 		}
+		PROFILE_END(PROFILE_SCHEDULE, schedule);
 
 		/* No process is ready to run at this moment */
 		if (!current) {
 			/* Quit simulation if no pending process exists */
-			if (list_empty(&readyqueue) && list_empty(&__forkqueue)) {
+			if (list_empty(&readyqueue) && list_empty(&__forkqueue) &&
+					heap_empty(&__sleepqueue)) {
 				break;
 			}
 
 			/* Idle temporarily */
-			fprintf(stderr, "%3d: idle\n", ticks);
+			__print_idle();
 		} else {
 
 			/* Execute the current process */
 			current->status = PROCESS_RUNNING;
+			if (current != prev) __switch_context();
+			metrics_dispatch(current, prev);
 
 			/* Ensure that @current is detached from any list */
 			assert(list_empty(&current->list));
 
 			/* Try acquiring scheduled resources */
-			if (__run_current_acquire()) {
+			PROFILE(PROFILE_ACQUIRE, acquired = __run_current_acquire());
+			if (acquired) {
 				/* Succesfully acquired all the resources to make a progress! */
-				__print_event(current->pid, "%d", current->pid);
+				__print_run(current->pid);
+				metrics_run(current);
 
 				/* So, it ages by one tick */
 				current->age++;
 
 				/* And performs scheduled releases */
-				__run_current_release();
+				PROFILE(PROFILE_RELEASE, __run_current_release());
+
+				/* Then goes to sleep if it starts I/O */
+				__run_current_io();
 			} else {
 				/**
 				 * The current is blocked while acquiring resource(s).
@@ -386,7 +934,12 @@ static void __do_simulation(void)
 
 		/* Increase the tick counter */
 		ticks++;
+		if (digest_interval && ticks >= __next_checkpoint) __checkpoint();
+		if (share_window && ticks % share_window == 0) metrics_share_window();
+		PROFILE_END(PROFILE_TICK, tick);
 	}
+
+	__flush_run();
 }
 
 
@@ -401,6 +954,11 @@ static void __initialize(void)
 
 	INIT_LIST_HEAD(&__forkqueue);
 
+	pool_init(&__process_pool, "process", sizeof(struct process));
+	pool_init(&__resource_schedule_pool, "resource_schedule",
+			sizeof(struct resource_schedule));
+	pool_init(&__io_schedule_pool, "io_schedule", sizeof(struct io_schedule));
+
 	if (quiet) return;
 	printf("               _              _ \n");
 	printf("              | |            | |\n");
@@ -418,15 +976,172 @@ static void __initialize(void)
 	printf("   =: Blocked\n");
 	printf("  +n: Acquire resource n\n");
 	printf("  -n: Release resource n\n");
+	printf("   I: Start I/O\n");
+	printf("   W: Complete I/O\n");
+	if (switch_cost) {
+		printf("   ~: Switching context\n");
+	}
 	printf("\n");
 }
 
 
+static void __report_pool(struct pool *pool)
+{
+	printf("pool.%s.object_bytes %zu\n", pool->name, pool->size);
+	printf("pool.%s.in_use_bytes %zu\n", pool->name, pool_bytes_in_use(pool));
+	printf("pool.%s.peak_bytes %zu\n", pool->name, pool_bytes_peak(pool));
+	printf("pool.%s.footprint_bytes %zu\n", pool->name, pool_bytes_footprint(pool));
+}
+
+static unsigned long long __clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void __report_stats(void)
+{
+	struct rusage usage;
+	double seconds = __simulation_ns / 1e9;
+
+	getrusage(RUSAGE_SELF, &usage);
+
+	printf("ticks %u\n", ticks);
+	printf("events %llu\n", __nr_events);
+	printf("load_ns %llu\n", __load_ns);
+	printf("simulation_ns %llu\n", __simulation_ns);
+	printf("ticks_per_sec %.0f\n", seconds > 0 ? ticks / seconds : 0);
+	printf("events_per_sec %.0f\n", seconds > 0 ? __nr_events / seconds : 0);
+	printf("peak_rss_kb %ld\n", usage.ru_maxrss);
+	__report_pool(&__process_pool);
+	__report_pool(&__resource_schedule_pool);
+	__report_pool(&__io_schedule_pool);
+}
+
+
+static bool __parse_output_format(char * const format)
+{
+	for (int i = 0; i < sizeof(__output_format_sz) / sizeof(*__output_format_sz); i++) {
+		if (strmatch(format, __output_format_sz[i])) {
+			output = i;
+			return true;
+		}
+	}
+	fprintf(stderr, "Unknown output format %s\n", format);
+	return false;
+}
+
+
+static bool __parse_engine(char * const engine)
+{
+	if (strmatch(engine, "list")) {
+		soa = false;
+	} else if (strmatch(engine, "soa")) {
+		soa = true;
+	} else {
+		fprintf(stderr, "Unknown engine %s\n", engine);
+		return false;
+	}
+	return true;
+}
+
+
+static bool __parse_digest_interval(char * const interval)
+{
+	char *end;
+	unsigned long n = strtoul(interval, &end, 10);
+
+	if (*end != '\0' || *interval == '-') {
+		fprintf(stderr, "Invalid digest interval %s\n", interval);
+		return false;
+	}
+	digest = true;
+	digest_interval = n;
+	__next_checkpoint = n;
+	return true;
+}
+
+
+static bool __parse_share_window(char * const window)
+{
+	char *end;
+	unsigned long n = strtoul(window, &end, 10);
+
+	if (*end != '\0' || *window == '-' || n == 0) {
+		fprintf(stderr, "Invalid share window %s\n", window);
+		return false;
+	}
+	share_window = n;
+	return true;
+}
+
+
+static bool __parse_horizon(char * const ticks)
+{
+	char *end;
+	unsigned long n = strtoul(ticks, &end, 10);
+
+	if (*end != '\0' || *ticks == '-' || n == 0) {
+		fprintf(stderr, "Invalid horizon %s\n", ticks);
+		return false;
+	}
+	horizon = n;
+	return true;
+}
+
+
+static bool __parse_tunable(char * const tunable)
+{
+	char *value = strchr(tunable, '=');
+
+	if (!value) {
+		fprintf(stderr, "Tunable should be given as name=value\n");
+		return false;
+	}
+	*value++ = '\0';
+	return set_tunable(tunable, value);
+}
+
+
+static bool __parse_switch_cost(char * const cost)
+{
+	char *end;
+	double c = strtod(cost, &end);
+
+	if (*end != '\0' || c < 0) {
+		fprintf(stderr, "Invalid context switch cost %s\n", cost);
+		return false;
+	}
+	switch_cost = (unsigned int)(c * SWITCH_COST_SCALE + 0.5);
+	return true;
+}
+
+
 static void __print_usage(char * const name)
 {
-	printf("Usage: %s {-q} -[f|s|S|r|a|p|i] [process script file]\n", name);
+	printf("Usage: %s {-q} {-m} {-H} {-b file} {-R} {-w ticks} {-T} {-x cost} {-d ticks} {-P ticks} {-k name=value} {-o format} {-E engine} -[f|s|S|r|a|p|i|c|F|V|L|D|M|l|t|O|j|J|n] [process script file]\n", name);
 	printf("\n");
-	printf("  -q: Run quietly\n\n");
+	printf("  -q: Run quietly\n");
+	printf("  -m: Report scheduling metrics of processes at exit\n");
+	printf("  -H: Report percentiles of waiting, response, and blocking time at exit\n");
+	printf("  -b: Dump the raw buckets of the latency histograms into a file\n");
+	printf("  -R: Report contention on resources and priority inversions at exit\n");
+	printf("  -w: Report the error of CPU shares against tickets over windows of the given ticks\n");
+	printf("  -T: Report statistics of the simulator at exit\n");
+	printf("  -x: Charge the given ticks (may be fractional) for each context switch\n");
+	printf("  -d: Print the digest of the event stream at exit and every given ticks (0 for at exit only)\n");
+	printf("  -P: Release periodic jobs until the given tick (default: one hyperperiod)\n");
+	printf("  -k: Set a tunable of the scheduler (e.g., cfs.latency=6)\n");
+	printf("  -o: Format of the event stream\n");
+	printf("        column : Indent events by pid (default)\n");
+	printf("        compact: Print pid as a field\n");
+	printf("        rle    : Compact, collapsing consecutive runs and idles\n");
+	printf("        none   : Do not print events at all\n");
+	printf("  -E: Engine to select the next process in SJF, SRTF, and priority schedulers\n");
+	printf("        list   : Walk through the ready queue (default)\n");
+	printf("        soa    : Run SIMD kernels over the structure-of-arrays ready table\n\n");
 	printf("  -f: Use FIFO scheduler (default)\n");
 	printf("  -s: Use SJF scheduler\n");
 	printf("  -S: Use SRTF scheduler\n");
@@ -435,6 +1150,17 @@ static void __print_usage(char * const name)
 	printf("  -a: Use Priority scheduler with aging\n");
 	printf("  -c: Use Priority scheduler with PCP\n");
 	printf("  -i: Use Priority scheduler with PIP\n");
+	printf("  -F: Use Completely Fair scheduler\n");
+	printf("  -V: Use EEVDF scheduler\n");
+	printf("  -L: Use Multi-level feedback queue scheduler\n");
+	printf("  -D: Use Earliest deadline first scheduler\n");
+	printf("  -M: Use Rate-monotonic scheduler\n");
+	printf("  -l: Use Lottery scheduler\n");
+	printf("  -t: Use Stride scheduler\n");
+	printf("  -O: Use O(1) scheduler\n");
+	printf("  -j: Use SJF scheduler predicting bursts by exponential averaging\n");
+	printf("  -J: Use SRTF scheduler predicting bursts by exponential averaging\n");
+	printf("  -n: Use Highest response ratio next scheduler\n");
 	printf("\n");
 }
 
@@ -444,11 +1170,69 @@ int main(int argc, char * const argv[])
 	int opt;
 	char *scriptfile;
 
-	while ((opt = getopt(argc, argv, "qfsSrpaich")) != -1) {
+	while ((opt = getopt(argc, argv, "qmHb:Rw:Tx:d:P:k:o:E:fsSrpaicFVLDMltOjJnh")) != -1) {
 		switch (opt) {
 		case 'q':
 			quiet = true;
 			break;
+		case 'm':
+			metrics = true;
+			break;
+		case 'H':
+			histograms = true;
+			break;
+		case 'b':
+			histograms = true;
+			histogram_dump = optarg;
+			break;
+		case 'R':
+			resource_metrics = true;
+			break;
+		case 'w':
+			if (!__parse_share_window(optarg)) {
+				__print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'T':
+			stats = true;
+			break;
+		case 'x':
+			if (!__parse_switch_cost(optarg)) {
+				__print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'd':
+			if (!__parse_digest_interval(optarg)) {
+				__print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'P':
+			if (!__parse_horizon(optarg)) {
+				__print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'k':
+			if (!__parse_tunable(optarg)) {
+				__print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'E':
+			if (!__parse_engine(optarg)) {
+				__print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'o':
+			if (!__parse_output_format(optarg)) {
+				__print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
 
 		case 'f':
 			sched = &fifo_scheduler;
@@ -474,6 +1258,39 @@ int main(int argc, char * const argv[])
 		case 'c':
 			sched = &pcp_scheduler;
 			break;
+		case 'F':
+			sched = &cfs_scheduler;
+			break;
+		case 'V':
+			sched = &eevdf_scheduler;
+			break;
+		case 'L':
+			sched = &mlfq_scheduler;
+			break;
+		case 'D':
+			sched = &edf_scheduler;
+			break;
+		case 'M':
+			sched = &rm_scheduler;
+			break;
+		case 'l':
+			sched = &lottery_scheduler;
+			break;
+		case 't':
+			sched = &stride_scheduler;
+			break;
+		case 'O':
+			sched = &o1_scheduler;
+			break;
+		case 'j':
+			sched = &psjf_scheduler;
+			break;
+		case 'J':
+			sched = &psrtf_scheduler;
+			break;
+		case 'n':
+			sched = &hrrn_scheduler;
+			break;
 		case 'h':
 		default:
 			__print_usage(argv[0]);
@@ -490,20 +1307,65 @@ int main(int argc, char * const argv[])
 
 	__initialize();
 
+	__load_ns = __clock_ns();
 	if (!__load_script(scriptfile)) {
 		return EXIT_FAILURE;
 	}
+	__set_horizon();
+	__load_ns = __clock_ns() - __load_ns;
 
 	if (sched->initialize && sched->initialize()) {
 		return EXIT_FAILURE;
 	}
 
+	__simulation_ns = __clock_ns();
+	profile_begin();
 	__do_simulation();
+	profile_end();
+	__simulation_ns = __clock_ns() - __simulation_ns;
 
 	if (sched->finalize) {
 		sched->finalize();
 	}
 
+	if (metrics) {
+		metrics_report(sched->name);
+	}
+
+	if (histograms) {
+		metrics_report_histograms(sched->name);
+	}
+
+	if (resource_metrics) {
+		metrics_report_resources(sched->name);
+	}
+
+	if (share_window) {
+		metrics_report_shares(sched->name);
+	}
+
+	if (histogram_dump) {
+		FILE *file = fopen(histogram_dump, "w");
+		if (!file) {
+			fprintf(stderr, "Cannot open %s\n", histogram_dump);
+			return EXIT_FAILURE;
+		}
+		metrics_dump_histograms(file);
+		fclose(file);
+	}
+
+	if (digest) {
+		printf("digest %016llx\n", __digest);
+	}
+
+	if (stats) {
+		__report_stats();
+	}
+
+	if (!quiet) {
+		profile_report(ticks);
+	}
+
 	return EXIT_SUCCESS;
 }
 /*          ******        DO NOT MODIFY THIS FILE        ******       */
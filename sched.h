@@ -113,4 +113,18 @@ struct scheduler {
 	void (*release)(int);
 };
 
+
+/***********************************************************************
+ * bool set_tunable(char * const name, char * const value)
+ *
+ * DESCRIPTION
+ *   Set the tunable @name of a scheduler to @value, as given with the -k
+ *   option in the form of name=value.
+ *
+ * RETURN
+ *   true on success
+ *   false if there is no such tunable or @value is invalid
+ */
+bool set_tunable(char * const name, char * const value);
+
 #endif
@@ -0,0 +1,183 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+/**
+ * Micro-benchmark comparing the walk over the ready queue against the
+ * SoA selection kernels with the same selection criteria as the SJF,
+ * SRTF, priority, and priority + aging schedulers in pa2.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "types.h"
+#include "list_head.h"
+#include "process.h"
+#include "pool.h"
+#include "soa.h"
+
+LIST_HEAD(readyqueue);
+
+static volatile unsigned long __sink;
+
+static double __now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Selections over the list, copied from the schedulers in pa2.c */
+static struct process *__walk_sjf(void)
+{
+	struct process *next = list_first_entry(&readyqueue, struct process, list);
+	struct process *cur;
+	list_for_each_entry(cur, &readyqueue, list) {
+		if (next->lifespan > cur->lifespan) next = cur;
+	}
+	return next;
+}
+
+static struct process *__walk_srtf(void)
+{
+	struct process *next = list_first_entry(&readyqueue, struct process, list);
+	struct process *cur;
+	list_for_each_entry(cur, &readyqueue, list) {
+		if ((next->lifespan - next->age) > (cur->lifespan - cur->age)) next = cur;
+	}
+	return next;
+}
+
+static struct process *__walk_prio(void)
+{
+	struct process *next = list_first_entry(&readyqueue, struct process, list);
+	struct process *cur;
+	list_for_each_entry(cur, &readyqueue, list) {
+		if (next->prio < cur->prio) next = cur;
+	}
+	return next;
+}
+
+static struct process *__walk_pa(void)
+{
+	struct process *next = list_first_entry(&readyqueue, struct process, list);
+	struct process *cur;
+	list_for_each_entry(cur, &readyqueue, list) {
+		cur->prio++;
+		if (next->prio < cur->prio) next = cur;
+	}
+	return next;
+}
+
+static unsigned int __soa_sjf(void)
+{
+	return soa_argmin(ready_table.lifespan, NULL, ready_table.seq, ready_table.nr);
+}
+
+static unsigned int __soa_srtf(void)
+{
+	return soa_argmin(ready_table.lifespan, ready_table.age, ready_table.seq, ready_table.nr);
+}
+
+static unsigned int __soa_prio(void)
+{
+	return soa_argmax(ready_table.prio, ready_table.seq, ready_table.nr);
+}
+
+static unsigned int __soa_pa(void)
+{
+	soa_add(ready_table.prio, ready_table.nr, 1);
+	return soa_argmax(ready_table.prio, ready_table.seq, ready_table.nr);
+}
+
+static const char *__policy_sz[] = { "sjf", "srtf", "prio", "pa" };
+static struct process *(*__walks[])(void) = {
+	__walk_sjf, __walk_srtf, __walk_prio, __walk_pa,
+};
+static unsigned int (*__kernels[])(void) = {
+	__soa_sjf, __soa_srtf, __soa_prio, __soa_pa,
+};
+
+static void __bench(unsigned int nr)
+{
+	struct pool pool;
+	struct process **procs = malloc(nr * sizeof(*procs));
+	unsigned int rounds = 100000000 / nr;
+	double t;
+
+	if (rounds < 5) rounds = 5;
+	if (rounds > 20000) rounds = 20000;
+
+	pool_init(&pool, "process", sizeof(struct process));
+	for (unsigned int i = 0; i < nr; i++) {
+		procs[i] = pool_alloc(&pool);
+		memset(procs[i], 0x00, sizeof(struct process));
+		procs[i]->pid = i + 1;
+		procs[i]->lifespan = 1 + rand() % 10000;
+		procs[i]->age = rand() % procs[i]->lifespan;
+		procs[i]->prio = rand() % MAX_PRIO;
+		procs[i]->__ready_slot = SOA_NO_SLOT;
+	}
+
+	/* Enqueue in a random order so that the list scatters over the heap */
+	for (unsigned int i = nr - 1; i > 0; i--) {
+		unsigned int j = rand() % (i + 1);
+		struct process *tmp = procs[i];
+		procs[i] = procs[j];
+		procs[j] = tmp;
+	}
+	soa = true;
+	for (unsigned int i = 0; i < nr; i++) {
+		ready_enqueue(procs[i]);
+	}
+
+	for (int p = 0; p < sizeof(__policy_sz) / sizeof(*__policy_sz); p++) {
+		printf("%-5s %8u  ", __policy_sz[p], nr);
+
+		t = __now();
+		for (unsigned int r = 0; r < rounds; r++) {
+			__sink += __walks[p]()->pid;
+		}
+		printf("list %9.1f", (__now() - t) / rounds);
+
+		for (enum soa_isa isa = SOA_ISA_SCALAR; isa <= soa_best_isa(); isa++) {
+			soa_set_isa(isa);
+			t = __now();
+			for (unsigned int r = 0; r < rounds; r++) {
+				__sink += __kernels[p]();
+			}
+			printf("  %s %9.1f", soa_isa_name(isa), (__now() - t) / rounds);
+		}
+		printf("\n");
+	}
+
+	INIT_LIST_HEAD(&readyqueue);
+	memset(&ready_table, 0x00, sizeof(ready_table));
+	pool_destroy(&pool);
+	free(procs);
+}
+
+int main(int argc, char * const argv[])
+{
+	unsigned int sizes[] = { 1000, 100000, 1000000 };
+
+	printf("ns per selection\n");
+	for (int i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+		__bench(sizes[i]);
+	}
+	return EXIT_SUCCESS;
+}
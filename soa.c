@@ -0,0 +1,446 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#include <stdlib.h>
+#include <limits.h>
+#include <assert.h>
+
+#include "soa.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SOA_X86
+#include <immintrin.h>
+#endif
+
+bool soa = false;
+struct proc_table ready_table;
+
+/**
+ * Next sequence number to stamp on an enqueued process
+ */
+static unsigned int __seq = 0;
+
+static void __ptable_grow(struct proc_table *t)
+{
+	t->max = t->max ? t->max * 2 : 1024;
+
+	t->prio = realloc(t->prio, t->max * sizeof(*t->prio));
+	t->age = realloc(t->age, t->max * sizeof(*t->age));
+	t->lifespan = realloc(t->lifespan, t->max * sizeof(*t->lifespan));
+	t->seq = realloc(t->seq, t->max * sizeof(*t->seq));
+	t->proc = realloc(t->proc, t->max * sizeof(*t->proc));
+
+	assert(t->prio && t->age && t->lifespan && t->seq && t->proc);
+}
+
+static struct proc_table *__renumbering;
+
+static int __compare_seq(const void *a, const void *b)
+{
+	unsigned int sa = __renumbering->seq[*(const unsigned int *)a];
+	unsigned int sb = __renumbering->seq[*(const unsigned int *)b];
+
+	return (sa > sb) - (sa < sb);
+}
+
+/**
+ * The sequence number is about to wrap around. Renumber the queued
+ * processes from 0 while keeping their relative order.
+ */
+static void __ptable_renumber(struct proc_table *t)
+{
+	unsigned int *slots = malloc(t->nr * sizeof(*slots));
+	assert(slots || t->nr == 0);
+
+	for (unsigned int i = 0; i < t->nr; i++) {
+		slots[i] = i;
+	}
+	__renumbering = t;
+	qsort(slots, t->nr, sizeof(*slots), __compare_seq);
+
+	for (unsigned int i = 0; i < t->nr; i++) {
+		t->seq[slots[i]] = i;
+	}
+	__seq = t->nr;
+	free(slots);
+}
+
+void ptable_add(struct proc_table *t, struct process *p)
+{
+	unsigned int slot;
+
+	assert(p->__ready_slot == SOA_NO_SLOT);
+
+	if (t->nr == t->max) __ptable_grow(t);
+	if (__seq == UINT_MAX) __ptable_renumber(t);
+
+	slot = t->nr++;
+	t->prio[slot] = p->prio;
+	t->age[slot] = p->age;
+	t->lifespan[slot] = p->lifespan;
+	t->seq[slot] = __seq++;
+	t->proc[slot] = p;
+
+	p->__ready_slot = slot;
+}
+
+void ptable_del(struct proc_table *t, struct process *p)
+{
+	unsigned int slot = p->__ready_slot;
+	unsigned int last = --t->nr;
+
+	assert(slot <= last && t->proc[slot] == p);
+
+	if (slot != last) {
+		t->prio[slot] = t->prio[last];
+		t->age[slot] = t->age[last];
+		t->lifespan[slot] = t->lifespan[last];
+		t->seq[slot] = t->seq[last];
+		t->proc[slot] = t->proc[last];
+		t->proc[slot]->__ready_slot = slot;
+	}
+	p->__ready_slot = SOA_NO_SLOT;
+}
+
+
+/***********************************************************************
+ * Kernels
+ *
+ * Each selection runs in three passes; find the extreme key, find the
+ * smallest sequence number among the entries having that key, and then
+ * find the slot having that sequence number.
+ ***********************************************************************/
+static inline unsigned int __key(const unsigned int *key,
+		const unsigned int *sub, unsigned int i)
+{
+	return sub ? key[i] - sub[i] : key[i];
+}
+
+static unsigned int __extreme_scalar(const unsigned int *key,
+		const unsigned int *sub, unsigned int nr, bool max)
+{
+	unsigned int e = max ? 0 : UINT_MAX;
+
+	for (unsigned int i = 0; i < nr; i++) {
+		unsigned int k = __key(key, sub, i);
+		if (max ? k > e : k < e) e = k;
+	}
+	return e;
+}
+
+static unsigned int __min_seq_scalar(const unsigned int *key,
+		const unsigned int *sub, const unsigned int *seq, unsigned int nr,
+		unsigned int val, unsigned int from)
+{
+	unsigned int s = UINT_MAX;
+
+	for (unsigned int i = from; i < nr; i++) {
+		if (__key(key, sub, i) == val && seq[i] < s) s = seq[i];
+	}
+	return s;
+}
+
+static unsigned int __find_scalar(const unsigned int *v, unsigned int nr,
+		unsigned int val, unsigned int from)
+{
+	for (unsigned int i = from; i < nr; i++) {
+		if (v[i] == val) return i;
+	}
+	return nr;
+}
+
+static void __add_scalar(unsigned int *v, unsigned int nr,
+		unsigned int delta, unsigned int from)
+{
+	for (unsigned int i = from; i < nr; i++) {
+		v[i] += delta;
+	}
+}
+
+#ifdef SOA_X86
+/* SSE4.1 */
+#define __sse_key(key, sub, i) (sub ? \
+	_mm_sub_epi32(_mm_loadu_si128((const __m128i *)(key + i)), \
+			_mm_loadu_si128((const __m128i *)(sub + i))) : \
+	_mm_loadu_si128((const __m128i *)(key + i)))
+
+__attribute__((target("sse4.1")))
+static unsigned int __extreme_sse41(const unsigned int *key,
+		const unsigned int *sub, unsigned int nr, bool max)
+{
+	unsigned int i = 0, e, lanes[4];
+	__m128i acc = _mm_set1_epi32(max ? 0 : -1);
+
+	for (; i + 4 <= nr; i += 4) {
+		__m128i k = __sse_key(key, sub, i);
+		acc = max ? _mm_max_epu32(acc, k) : _mm_min_epu32(acc, k);
+	}
+	_mm_storeu_si128((__m128i *)lanes, acc);
+
+	e = __extreme_scalar(lanes, NULL, 4, max);
+	if (i < nr) {
+		unsigned int t = __extreme_scalar(key + i, sub ? sub + i : NULL, nr - i, max);
+		if (max ? t > e : t < e) e = t;
+	}
+	return e;
+}
+
+__attribute__((target("sse4.1")))
+static unsigned int __min_seq_sse41(const unsigned int *key,
+		const unsigned int *sub, const unsigned int *seq, unsigned int nr,
+		unsigned int val)
+{
+	unsigned int i = 0, s, t, lanes[4];
+	__m128i acc = _mm_set1_epi32(-1);
+	__m128i v = _mm_set1_epi32(val);
+
+	for (; i + 4 <= nr; i += 4) {
+		__m128i eq = _mm_cmpeq_epi32(__sse_key(key, sub, i), v);
+		__m128i sq = _mm_loadu_si128((const __m128i *)(seq + i));
+		acc = _mm_min_epu32(acc, _mm_or_si128(sq, _mm_andnot_si128(eq, _mm_set1_epi32(-1))));
+	}
+	_mm_storeu_si128((__m128i *)lanes, acc);
+
+	s = __extreme_scalar(lanes, NULL, 4, false);
+	t = __min_seq_scalar(key, sub, seq, nr, val, i);
+	return t < s ? t : s;
+}
+
+__attribute__((target("sse4.1")))
+static unsigned int __find_sse41(const unsigned int *v, unsigned int nr,
+		unsigned int val)
+{
+	unsigned int i = 0;
+	__m128i x = _mm_set1_epi32(val);
+
+	for (; i + 4 <= nr; i += 4) {
+		__m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(v + i)), x);
+		int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+		if (mask) return i + __builtin_ctz(mask);
+	}
+	return __find_scalar(v, nr, val, i);
+}
+
+__attribute__((target("sse4.1")))
+static void __add_sse41(unsigned int *v, unsigned int nr, unsigned int delta)
+{
+	unsigned int i = 0;
+	__m128i d = _mm_set1_epi32(delta);
+
+	for (; i + 4 <= nr; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(v + i));
+		_mm_storeu_si128((__m128i *)(v + i), _mm_add_epi32(x, d));
+	}
+	__add_scalar(v, nr, delta, i);
+}
+
+/* AVX2 */
+#define __avx_key(key, sub, i) (sub ? \
+	_mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(key + i)), \
+			_mm256_loadu_si256((const __m256i *)(sub + i))) : \
+	_mm256_loadu_si256((const __m256i *)(key + i)))
+
+__attribute__((target("avx2")))
+static unsigned int __extreme_avx2(const unsigned int *key,
+		const unsigned int *sub, unsigned int nr, bool max)
+{
+	unsigned int i = 0, e, lanes[8];
+	__m256i acc = _mm256_set1_epi32(max ? 0 : -1);
+
+	for (; i + 8 <= nr; i += 8) {
+		__m256i k = __avx_key(key, sub, i);
+		acc = max ? _mm256_max_epu32(acc, k) : _mm256_min_epu32(acc, k);
+	}
+	_mm256_storeu_si256((__m256i *)lanes, acc);
+
+	e = __extreme_scalar(lanes, NULL, 8, max);
+	if (i < nr) {
+		unsigned int t = __extreme_scalar(key + i, sub ? sub + i : NULL, nr - i, max);
+		if (max ? t > e : t < e) e = t;
+	}
+	return e;
+}
+
+__attribute__((target("avx2")))
+static unsigned int __min_seq_avx2(const unsigned int *key,
+		const unsigned int *sub, const unsigned int *seq, unsigned int nr,
+		unsigned int val)
+{
+	unsigned int i = 0, s, t, lanes[8];
+	__m256i acc = _mm256_set1_epi32(-1);
+	__m256i v = _mm256_set1_epi32(val);
+
+	for (; i + 8 <= nr; i += 8) {
+		__m256i eq = _mm256_cmpeq_epi32(__avx_key(key, sub, i), v);
+		__m256i sq = _mm256_loadu_si256((const __m256i *)(seq + i));
+		acc = _mm256_min_epu32(acc, _mm256_or_si256(sq, _mm256_andnot_si256(eq, _mm256_set1_epi32(-1))));
+	}
+	_mm256_storeu_si256((__m256i *)lanes, acc);
+
+	s = __extreme_scalar(lanes, NULL, 8, false);
+	t = __min_seq_scalar(key, sub, seq, nr, val, i);
+	return t < s ? t : s;
+}
+
+__attribute__((target("avx2")))
+static unsigned int __find_avx2(const unsigned int *v, unsigned int nr,
+		unsigned int val)
+{
+	unsigned int i = 0;
+	__m256i x = _mm256_set1_epi32(val);
+
+	for (; i + 8 <= nr; i += 8) {
+		__m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(v + i)), x);
+		int mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+		if (mask) return i + __builtin_ctz(mask);
+	}
+	return __find_scalar(v, nr, val, i);
+}
+
+__attribute__((target("avx2")))
+static void __add_avx2(unsigned int *v, unsigned int nr, unsigned int delta)
+{
+	unsigned int i = 0;
+	__m256i d = _mm256_set1_epi32(delta);
+
+	for (; i + 8 <= nr; i += 8) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)(v + i));
+		_mm256_storeu_si256((__m256i *)(v + i), _mm256_add_epi32(x, d));
+	}
+	__add_scalar(v, nr, delta, i);
+}
+#endif
+
+static enum soa_isa __isa = SOA_ISA_SCALAR;
+static bool __isa_probed = false;
+
+static const char * __soa_isa_sz[] = {
+	"scalar",
+	"sse4.1",
+	"avx2",
+};
+
+enum soa_isa soa_best_isa(void)
+{
+#ifdef SOA_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return SOA_ISA_AVX2;
+	if (__builtin_cpu_supports("sse4.1")) return SOA_ISA_SSE41;
+#endif
+	return SOA_ISA_SCALAR;
+}
+
+void soa_set_isa(enum soa_isa isa)
+{
+	assert(isa <= soa_best_isa());
+	__isa = isa;
+	__isa_probed = true;
+}
+
+const char *soa_isa_name(enum soa_isa isa)
+{
+	return __soa_isa_sz[isa];
+}
+
+static inline enum soa_isa __soa_isa(void)
+{
+	if (!__isa_probed) soa_set_isa(soa_best_isa());
+	return __isa;
+}
+
+static unsigned int __extreme(const unsigned int *key,
+		const unsigned int *sub, unsigned int nr, bool max)
+{
+	switch (__soa_isa()) {
+#ifdef SOA_X86
+	case SOA_ISA_AVX2:
+		return __extreme_avx2(key, sub, nr, max);
+	case SOA_ISA_SSE41:
+		return __extreme_sse41(key, sub, nr, max);
+#endif
+	default:
+		return __extreme_scalar(key, sub, nr, max);
+	}
+}
+
+static unsigned int __min_seq(const unsigned int *key,
+		const unsigned int *sub, const unsigned int *seq, unsigned int nr,
+		unsigned int val)
+{
+	switch (__soa_isa()) {
+#ifdef SOA_X86
+	case SOA_ISA_AVX2:
+		return __min_seq_avx2(key, sub, seq, nr, val);
+	case SOA_ISA_SSE41:
+		return __min_seq_sse41(key, sub, seq, nr, val);
+#endif
+	default:
+		return __min_seq_scalar(key, sub, seq, nr, val, 0);
+	}
+}
+
+static unsigned int __find(const unsigned int *v, unsigned int nr,
+		unsigned int val)
+{
+	switch (__soa_isa()) {
+#ifdef SOA_X86
+	case SOA_ISA_AVX2:
+		return __find_avx2(v, nr, val);
+	case SOA_ISA_SSE41:
+		return __find_sse41(v, nr, val);
+#endif
+	default:
+		return __find_scalar(v, nr, val, 0);
+	}
+}
+
+unsigned int soa_argmin(const unsigned int *key, const unsigned int *sub,
+		const unsigned int *seq, unsigned int nr)
+{
+	unsigned int k;
+
+	assert(nr > 0);
+
+	k = __extreme(key, sub, nr, false);
+	return __find(seq, nr, __min_seq(key, sub, seq, nr, k));
+}
+
+unsigned int soa_argmax(const unsigned int *key,
+		const unsigned int *seq, unsigned int nr)
+{
+	unsigned int k;
+
+	assert(nr > 0);
+
+	k = __extreme(key, NULL, nr, true);
+	return __find(seq, nr, __min_seq(key, NULL, seq, nr, k));
+}
+
+void soa_add(unsigned int *v, unsigned int nr, unsigned int delta)
+{
+	switch (__soa_isa()) {
+#ifdef SOA_X86
+	case SOA_ISA_AVX2:
+		__add_avx2(v, nr, delta);
+		break;
+	case SOA_ISA_SSE41:
+		__add_sse41(v, nr, delta);
+		break;
+#endif
+	default:
+		__add_scalar(v, nr, delta, 0);
+		break;
+	}
+}
@@ -0,0 +1,134 @@
+/**********************************************************************
+ * Copyright (c) 2019-2021
+ *  Sang-Hoon Kim <sanghoonkim@ajou.ac.kr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTIABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ **********************************************************************/
+
+#ifndef __SOA_H__
+#define __SOA_H__
+
+#include "types.h"
+#include "list_head.h"
+#include "process.h"
+
+/***********************************************************************
+ * struct proc_table
+ *
+ * DESCRIPTION
+ *   Structure-of-arrays mirror of the ready queue. The fields that the
+ *   policies scan over are kept in dense arrays indexed by slot so that
+ *   the selection can run over contiguous memory with SIMD instructions.
+ *   Slots are recycled by moving the last entry into the hole, so the
+ *   table is not ordered. @seq records the order of enqueueing instead,
+ *   and the kernels break ties with it to pick exactly the same process
+ *   as the walk over the ready queue does.
+ */
+struct proc_table {
+	unsigned int nr;
+	unsigned int max;
+
+	unsigned int *prio;
+	unsigned int *age;
+	unsigned int *lifespan;
+	unsigned int *seq;
+	struct process **proc;
+};
+
+#define SOA_NO_SLOT		(~0U)
+
+/**
+ * True if the simulator was started with -E soa. Then @ready_table mirrors
+ * @readyqueue and policies may select the next process from the table
+ */
+extern bool soa;
+extern struct proc_table ready_table;
+extern struct list_head readyqueue;
+
+void ptable_add(struct proc_table *t, struct process *p);
+void ptable_del(struct proc_table *t, struct process *p);
+
+
+/***********************************************************************
+ * Selection kernels
+ *
+ * DESCRIPTION
+ *   soa_argmin() returns the slot with the smallest @key[i] - @sub[i]
+ *   (@sub may be NULL), and soa_argmax() returns the slot with the largest
+ *   @key[i]. Both break ties by the smallest @seq[i]. soa_add() adds @delta
+ *   to every element of @v.
+ *
+ *   The kernels are dispatched to SSE4.1 or AVX2 variants at run time
+ *   depending on the processor. soa_set_isa() overrides it.
+ */
+enum soa_isa {
+	SOA_ISA_SCALAR,
+	SOA_ISA_SSE41,
+	SOA_ISA_AVX2,
+};
+
+void soa_set_isa(enum soa_isa isa);
+enum soa_isa soa_best_isa(void);
+const char *soa_isa_name(enum soa_isa isa);
+
+unsigned int soa_argmin(const unsigned int *key, const unsigned int *sub,
+		const unsigned int *seq, unsigned int nr);
+unsigned int soa_argmax(const unsigned int *key,
+		const unsigned int *seq, unsigned int nr);
+void soa_add(unsigned int *v, unsigned int nr, unsigned int delta);
+
+
+/***********************************************************************
+ * Ready queue accessors
+ *
+ * DESCRIPTION
+ *   Put @p into and take @p out of the ready queue, keeping @ready_table
+ *   in sync when the SoA engine is active. The table holds the live
+ *   priority of queued processes, so ready_dequeue() writes it back and
+ *   ready_update() should be called after changing the priority of a
+ *   process that may be in the ready queue.
+ */
+static inline void ready_enqueue(struct process *p)
+{
+	list_add_tail(&p->list, &readyqueue);
+	if (soa) ptable_add(&ready_table, p);
+}
+
+static inline void ready_dequeue(struct process *p)
+{
+	list_del_init(&p->list);
+	if (soa) {
+		p->prio = ready_table.prio[p->__ready_slot];
+		ptable_del(&ready_table, p);
+	}
+}
+
+static inline void ready_update(struct process *p)
+{
+	if (soa && p->__ready_slot != SOA_NO_SLOT) {
+		ready_table.prio[p->__ready_slot] = p->prio;
+	}
+}
+
+static inline unsigned int ready_prio(struct process *p)
+{
+	if (soa && p->__ready_slot != SOA_NO_SLOT) {
+		return ready_table.prio[p->__ready_slot];
+	}
+	return p->prio;
+}
+
+static inline struct process *ready_table_entry(unsigned int slot)
+{
+	return ready_table.proc[slot];
+}
+
+#endif